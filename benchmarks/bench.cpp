@@ -1,10 +1,17 @@
 #include <iostream>
 
+#include "./../hashmap_implementations/Cuckoo.h"
+#include "./../hashmap_implementations/Hopscotch.h"
 #include "./../hashmap_implementations/LPmap3.h"
+#include "./../hashmap_implementations/LPatomic.h"
+#include "./../hashmap_implementations/LPrcu.h"
+#include "./../hashmap_implementations/LPsharded.h"
+#include "./../hashmap_implementations/LPsplit.h"
 #include "./../hashmap_implementations/Nodemap.h"
 #include "./includes/3thparty/CLI11.hpp"
 #include "./includes/aggregate_tests.h"
 #include "./includes/bigtype.h"
+#include "./includes/concurrent_tests.h"
 // include your implementations
 
 string choicetext
@@ -14,6 +21,15 @@ string choicetext
       "2. boost::unordered\n"
       "3. LP maps (sagar)\n"
       "4. NM maps (sagar)\n"
+      "5. LP3 with split key/value storage\n"
+      "6. LP3 probe policies: linear, quadratic, double hashing\n"
+      "7. bucketized cuckoo map\n"
+      "8. hopscotch map\n"
+      "9. multithreaded scaling: LP3 behind 1 mutex, LP3Sharded and the lock-free LP3Atomic\n"
+      "10. read-mostly scaling: LP3Rcu vs LP3Sharded vs LP3 behind 1 mutex\n"
+      "11. merging per-thread LP3s: inserting 1 by 1 vs merge_parallel\n"
+      "12. compaction pass (transform, reduce, erase_if): serial vs on a thread pool\n"
+      "13. string keys of 8 to 256 chars: LP3 with std::hash and std::equal_to vs its default LP::string_hash\n"
 
 
 
@@ -48,7 +64,7 @@ int main(int argc, char **argv)
             case 1: {
                 int_test_aggregate(std::unordered_map<int, int>{}, runs, maxsize);
                 string_test_aggregate(std::unordered_map<string, string>{}, runs, maxsize);  // TODO:
-//                bigtype_test_aggregate(std::unordered_map<Big,Big>{}, runs, maxsize);
+                bigtype_test_aggregate(std::unordered_map<string, Big>{}, runs, maxsize);
                 break;
             }
                 //            case 2: {
@@ -59,7 +75,7 @@ int main(int argc, char **argv)
             case 3: {
                 int_test_aggregate(LP3<int, int>{}, runs, maxsize);
                 string_test_aggregate(LP3<string, string>{}, runs, maxsize);
-//                bigtype_test_aggregate(LP3<Big,Big>{}, runs, maxsize);
+                bigtype_test_aggregate(LP3<string, Big>{}, runs, maxsize);
 
                 break;
             }
@@ -68,10 +84,71 @@ int main(int argc, char **argv)
                 //                string_test_aggregate(Nodemap<string, string>{}, runs, maxsize);
                 //                break;
                 //            }
-                //            case 5: {
-                //
-                //                break;
-                //            }
+            case 5: {
+                int_test_aggregate(LP3Split<int, int>{}, runs, maxsize);
+                string_test_aggregate(LP3Split<string, string>{}, runs, maxsize);
+                bigtype_test_aggregate(LP3Split<string, Big>{}, runs, maxsize);
+                break;
+            }
+            case 6: {
+                using linear = LP3<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>,
+                                   LP::linear_probe>;
+                using quadratic = LP3<int, int, std::hash<int>, std::equal_to<int>,
+                                      std::allocator<std::pair<const int, int>>, LP::quadratic_probe>;
+                using double_hash = LP3<int, int, std::hash<int>, std::equal_to<int>,
+                                        std::allocator<std::pair<const int, int>>, LP::double_hash_probe>;
+                int_test_aggregate(quadratic{}, runs, maxsize);
+                int_test_aggregate(double_hash{}, runs, maxsize);
+                // sequential keys give linear probing a single cluster of n buckets, so a miss costs ~n/4 probes.
+                // that's the point of the metric, but it gets too slow to measure past a million.
+                int cluster_max = std::min(maxsize, 1000000);
+                cluster_test_aggregate(linear{}, cluster_max);
+                cluster_test_aggregate(quadratic{}, cluster_max);
+                cluster_test_aggregate(double_hash{}, cluster_max);
+                break;
+            }
+            case 7: {
+                int_test_aggregate(CuckooMap<int, int>{}, runs, maxsize);
+                string_test_aggregate(CuckooMap<string, string>{}, runs, maxsize);
+                bigtype_test_aggregate(CuckooMap<string, Big>{}, runs, maxsize);
+                break;
+            }
+            case 8: {
+                int_test_aggregate(HopscotchMap<int, int>{}, runs, maxsize);
+                string_test_aggregate(HopscotchMap<string, string>{}, runs, maxsize);
+                bigtype_test_aggregate(HopscotchMap<string, Big>{}, runs, maxsize);
+                break;
+            }
+            case 9: {
+                int concurrent_size = std::min(maxsize, 1000000);
+                concurrent_test_aggregate<single_lock_map<LP3<int, int>>>(runs, concurrent_size);
+                concurrent_test_aggregate<LP3Sharded<int, int>>(runs, concurrent_size);
+                concurrent_test_aggregate<LP3Atomic<int, int>>(runs, concurrent_size);
+                break;
+            }
+            case 10: {
+                int read_mostly_size = std::min(maxsize, 1000000);
+                read_mostly_test_aggregate<single_lock_map<LP3<int, int>>>(runs, read_mostly_size);
+                read_mostly_test_aggregate<LP3Sharded<int, int>>(runs, read_mostly_size);
+                read_mostly_test_aggregate<LP3Rcu<int, int>>(runs, read_mostly_size);
+                break;
+            }
+            case 11: {
+                merge_test_aggregate(runs, std::min(maxsize, 10000000));
+                break;
+            }
+            case 12: {
+                compaction_test_aggregate(runs, std::min(maxsize, 10000000));
+                break;
+            }
+            case 13: {
+                using std_hashed = LP3<string, string, std::hash<string>, std::equal_to<string>>;
+                // 2 copies of every key, so 256 char keys at a million elements is already 600MB
+                int length_size = std::min(maxsize, 1000000);
+                string_length_test_aggregate(std_hashed{}, runs, length_size);
+                string_length_test_aggregate(LP3<string, string>{}, runs, length_size);
+                break;
+            }
         }
 
         time_point<steady_clock> end_test = steady_clock::now();
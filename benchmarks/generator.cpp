@@ -2,20 +2,16 @@
 #include "./includes/generator.h"  // imports a generator to be used for the functions
 
 // generates string to be used as a key
-std::string gen_string()
-{  // 90^inserted posibilities
-    std::string randomstring;
-    for (int i = 0; i < 5; ++i) {
-        randomstring += singlechar(generator);
-    }
-    return randomstring;
-}
+std::string gen_string() { return gen_string_of_length(5); }
 // gen strings that dont exist in the hashmap
-std::string gen_unsuccesfull_string()
-{  // 90^inserted posibilities
+std::string gen_unsuccesfull_string() { return gen_string_of_length(4); }
+
+// random string of length chars. keys of 1 length are never keys of another
+std::string gen_string_of_length(int length)
+{  // 90^length posibilities
     std::string randomstring;
-    for (int i = 0; i < 4; ++i) {
-        randomstring += singlechar(generator);  //
+    for (int i = 0; i < length; ++i) {
+        randomstring += singlechar(generator);
     }
     return randomstring;
 }
@@ -69,12 +69,15 @@ void int_test_aggregate(T map, int runs, int maxsize = 20000000)
         string nosucc_lookup = "\nint_nosucc_lookup, \"";
         string delet = "\nint_delete, \"";
         string iter = "\nint_iter, \"";
+        string memory = "\nint_bytes_per_element, \"";
+        bool has_memory = false;
 
         insert += string{name(map)} + "\"";
         succ_lookup += string{name(map)} + "\"";
         nosucc_lookup += string{name(map)} + "\"";
         delet += string{name(map)} + "\"";
         iter += string{name(map)} + "\"";
+        memory += string{name(map)} + "\"";
         for (auto size : sizes) {
             if (size > maxsize) {
                 break;
@@ -86,80 +89,135 @@ void int_test_aggregate(T map, int runs, int maxsize = 20000000)
             nosucc_lookup += ", " + std::to_string(results[2]);
             delet += ", " + std::to_string(results[3]);
             iter += ", " + std::to_string(results[4]);
+            has_memory = has_memory || results[5] >= 0;
+            memory += ", " + std::to_string(results[5]);
         }
         output << insert << succ_lookup << nosucc_lookup << delet << iter;
         cout << insert << succ_lookup << nosucc_lookup << delet << iter;
+        if (has_memory) {
+            output << memory;
+            cout << memory;
+        }
     }
 }
 
 /*
 This is pretty much the same function, but it calls string_test instead of
 int_test. More info on why we needed to split this, can be seen in tests.h
+V is the value type, test names the rows (string_insert, ...)
 */
-template <class T>
-void string_test_aggregate(T map, int runs, int maxsize = 20000000)
+template <class T, class V = string>
+void string_test_aggregate(T map, int runs, int maxsize = 20000000, const string& test = "string")
 {
     std::ofstream output{"results.csv", std::ios_base::app};
     for (int i = 0; i < runs; ++i) {
-        string insert = "\nstring_insert, \"";
-        string succ_lookup = "\nstring_succ_lookup, \"";
-        string nosucc_lookup = "\nstring_nosucc_lookup, \"";
-        string delet = "\nstring_delete, \"";
-        string iter = "\nstring_iter, \"";
+        string insert = "\n" + test + "_insert, \"";
+        string succ_lookup = "\n" + test + "_succ_lookup, \"";
+        string nosucc_lookup = "\n" + test + "_nosucc_lookup, \"";
+        string delet = "\n" + test + "_delete, \"";
+        string iter = "\n" + test + "_iter, \"";
+        string memory = "\n" + test + "_bytes_per_element, \"";
+        bool has_memory = false;
 
         insert += string{name(map)} + "\"";
         succ_lookup += string{name(map)} + "\"";
         nosucc_lookup += string{name(map)} + "\"";
         delet += string{name(map)} + "\"";
         iter += string{name(map)} + "\"";
+        memory += string{name(map)} + "\"";
         for (auto size : sizes) {
             if (size > maxsize) {
                 break;
             }
-            vector<long int> results = string_test<T>(size);
+            vector<long int> results = string_test<T, V>(size);
 
             insert += ", " + std::to_string(results[0]);
             succ_lookup += ", " + std::to_string(results[1]);
             nosucc_lookup += ", " + std::to_string(results[2]);
             delet += ", " + std::to_string(results[3]);
             iter += ", " + std::to_string(results[4]);
+            has_memory = has_memory || results[5] >= 0;
+            memory += ", " + std::to_string(results[5]);
         }
         output << insert << succ_lookup << nosucc_lookup << delet << iter;
         cout << insert << succ_lookup << nosucc_lookup << delet << iter;
+        if (has_memory) {
+            output << memory;
+            cout << memory;
+        }
     }
 }
 
+/*
+string_test at 1 size, for keys of 8 to 256 chars. The columns are key lengths instead of sizes,
+so the rows show what hashing and comparing longer keys costs.
+*/
 template <class T>
-void bigtype_test_aggregate(T map, int runs, int maxsize = 20000000)
+void string_length_test_aggregate(T map, int runs, int size = 1000000)
 {
     std::ofstream output{"results.csv", std::ios_base::app};
     for (int i = 0; i < runs; ++i) {
-        string insert = "\nbigtype_insert, \"";
-        string succ_lookup = "\nbigtype_succ_lookup, \"";
-        string nosucc_lookup = "\nbigtype_nosucc_lookup, \"";
-        string delet = "\nbigtype_delete, \"";
-        string iter = "\nbigtype_iter, \"";
+        string insert = "\nstring_length_insert, \"";
+        string succ_lookup = "\nstring_length_succ_lookup, \"";
+        string nosucc_lookup = "\nstring_length_nosucc_lookup, \"";
+        string delet = "\nstring_length_delete, \"";
 
         insert += string{name(map)} + "\"";
         succ_lookup += string{name(map)} + "\"";
         nosucc_lookup += string{name(map)} + "\"";
         delet += string{name(map)} + "\"";
-        iter += string{name(map)} + "\"";
-        for (auto size : sizes) {
-            if (size > maxsize) {
-                break;
-            }
-            vector<long int> results = int_test<T>(size);
+        for (int key_length : {8, 16, 32, 64, 128, 256}) {
+            vector<long int> results = string_test<T>(size, key_length);
 
             insert += ", " + std::to_string(results[0]);
             succ_lookup += ", " + std::to_string(results[1]);
             nosucc_lookup += ", " + std::to_string(results[2]);
             delet += ", " + std::to_string(results[3]);
-            iter += ", " + std::to_string(results[4]);
         }
-        output << insert << succ_lookup << nosucc_lookup << delet << iter;
-        cout << insert << succ_lookup << nosucc_lookup << delet << iter;
+        output << insert << succ_lookup << nosucc_lookup << delet;
+        cout << insert << succ_lookup << nosucc_lookup << delet;
     }
 }
 
-#endif
\ No newline at end of file
+/*
+Same again, for string keys with Big values. see string_test in tests.h
+*/
+template <class T>
+void bigtype_test_aggregate(T map, int runs, int maxsize = 20000000)
+{
+    string_test_aggregate<T, Big>(map, runs, maxsize, "bigtype");
+}
+
+/*
+Cluster metrics instead of timings, see cluster_test in tests.h.
+Rows are written for random and for sequential int keys.
+*/
+template <class T>
+void cluster_test_aggregate(T map, int maxsize = 20000000)
+{
+    std::ofstream output{"results.csv", std::ios_base::app};
+    for (bool sequential : {false, true}) {
+        string distribution = sequential ? "sequential" : "random";
+        string succ_probes = "\nint_" + distribution + "_succ_probe_length, \"";
+        string nosucc_probes = "\nint_" + distribution + "_nosucc_probe_length, \"";
+        string longest_run = "\nint_" + distribution + "_longest_cluster, \"";
+
+        succ_probes += string{name(map)} + "\"";
+        nosucc_probes += string{name(map)} + "\"";
+        longest_run += string{name(map)} + "\"";
+        for (auto size : sizes) {
+            if (size > maxsize) {
+                break;
+            }
+            vector<long int> results = cluster_test<T>(size, sequential);
+
+            succ_probes += ", " + std::to_string(results[0]);
+            nosucc_probes += ", " + std::to_string(results[1]);
+            longest_run += ", " + std::to_string(results[2]);
+        }
+        output << succ_probes << nosucc_probes << longest_run;
+        cout << succ_probes << nosucc_probes << longest_run;
+    }
+}
+
+#endif
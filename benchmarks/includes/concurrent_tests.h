@@ -0,0 +1,368 @@
+#ifndef CONCURRENT_TESTS_H
+#define CONCURRENT_TESTS_H
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "./../../hashmap_implementations/LPatomic.h"
+#include "./../../hashmap_implementations/LPrcu.h"
+#include "./aggregate_tests.h"
+
+/*
+What we compare the concurrent maps against: any map behind a single mutex,
+with the same interface as LP3Sharded (the parts concurrent_test uses).
+*/
+template <class Map>
+struct single_lock_map {
+    std::mutex lock;
+    Map map;
+
+    void reserve(size_t size)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        map.reserve(size);
+    }
+    bool insert(const typename Map::value_type& kv)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return map.insert(kv).second;
+    }
+    bool insert_or_assign(int k, int v)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return map.insert_or_assign(k, v).second;
+    }
+    bool find(int key, int& out)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+    template <class F>
+    void update(int key, F f)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        f(map[key]);
+    }
+};
+
+/*
+insert-or-increment, the only thing counting_test does. The locked maps do it under their lock,
+LP3Atomic has its own lock-free add.
+*/
+template <class T>
+void increment(T& testmap, int key)
+{
+    testmap.update(key, [](int& n) { n++; });
+}
+template <class K, class V>
+void increment(LP3Atomic<K, V>& testmap, int key)
+{
+    testmap.fetch_add(key, 1);
+}
+
+/*
+Scaling test for maps that can be used from many threads at once.
+1. fill the map with size keys from 1 thread
+2. start threads threads, that together do 4 million operations on random keys of the map.
+   write_percent of those are insert_or_assign, the rest are lookups.
+3. return the throughput in operations per millisecond, so higher is better here, unlike the other tests.
+Each thread has its own generator, the global one isn't thread safe.
+*/
+template <class T>
+long int concurrent_test(T& testmap, int threads, int size, int write_percent)
+{
+    const int total_ops = 4000000;
+    vector<int> keys(size);
+    std::generate(keys.begin(), keys.end(), gen_int);
+    testmap.reserve(size);
+    for (auto key : keys) {
+        testmap.insert({key, key});
+    }
+
+    auto work = [&](int thread_id) {
+        std::mt19937 local_gen(thread_id);
+        std::uniform_int_distribution<int> pick(0, size - 1);
+        std::uniform_int_distribution<int> percent(0, 99);
+        int found = 0;
+        for (int i = 0; i < total_ops / threads; i++) {
+            int key = keys[pick(local_gen)];
+            if (percent(local_gen) < write_percent) {
+                testmap.insert_or_assign(key, i);
+            }
+            else {
+                int value;
+                found += testmap.find(key, value);
+            }
+        }
+        if (found == -1) cout << "WTF";
+    };
+
+    time_point<steady_clock> start = steady_clock::now();
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(work, t);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    time_point<steady_clock> end = steady_clock::now();
+    long int millis = std::max<long int>(1, duration_cast<milliseconds>(end - start).count());
+    return total_ops / millis;
+}
+
+/*
+Aggregation from many threads: 4 million insert-or-increments on keys drawn from distinct_keys random ones,
+starting from an empty map so the resizes happen while all threads are busy.
+return the throughput in operations per millisecond.
+*/
+template <class T>
+long int counting_test(T& testmap, int threads, int distinct_keys)
+{
+    const int total_ops = 4000000;
+    vector<int> keys(distinct_keys);
+    std::generate(keys.begin(), keys.end(), gen_int);
+
+    auto work = [&](int thread_id) {
+        std::mt19937 local_gen(thread_id);
+        std::uniform_int_distribution<int> pick(0, distinct_keys - 1);
+        for (int i = 0; i < total_ops / threads; i++) {
+            increment(testmap, keys[pick(local_gen)]);
+        }
+    };
+
+    time_point<steady_clock> start = steady_clock::now();
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(work, t);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    time_point<steady_clock> end = steady_clock::now();
+    long int millis = std::max<long int>(1, duration_cast<milliseconds>(end - start).count());
+    return total_ops / millis;
+}
+
+/*
+puts (key, key) in the map for every key. LP3Rcu copies itself on every insert, so it gets them in 1 batch.
+*/
+template <class T>
+void fill(T& testmap, const vector<int>& keys)
+{
+    testmap.reserve(keys.size());
+    for (auto key : keys) {
+        testmap.insert({key, key});
+    }
+}
+template <class K, class V>
+void fill(LP3Rcu<K, V>& testmap, const vector<int>& keys)
+{
+    testmap.update([&](typename LP3Rcu<K, V>::Map& map) {
+        map.reserve(keys.size());
+        for (auto key : keys) {
+            map.insert({key, key});
+        }
+    });
+}
+
+/*
+Like a routing table: threads threads do 4 million lookups between them, while 1 more thread
+changes a random key 10 times a second. Only the lookups count for the throughput, in operations per millisecond.
+*/
+template <class T>
+long int read_mostly_test(T& testmap, int threads, int size)
+{
+    const int total_ops = 4000000;
+    vector<int> keys(size);
+    std::generate(keys.begin(), keys.end(), gen_int);
+    fill(testmap, keys);
+
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 0; !done.load(); i++) {
+            testmap.insert_or_assign(keys[i % size], i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+    auto work = [&](int thread_id) {
+        std::mt19937 local_gen(thread_id);
+        std::uniform_int_distribution<int> pick(0, size - 1);
+        int found = 0;
+        for (int i = 0; i < total_ops / threads; i++) {
+            int value;
+            found += testmap.find(keys[pick(local_gen)], value);
+        }
+        if (found == -1) cout << "WTF";
+    };
+
+    time_point<steady_clock> start = steady_clock::now();
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(work, t);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    time_point<steady_clock> end = steady_clock::now();
+    done.store(true);
+    writer.join();
+    long int millis = std::max<long int>(1, duration_cast<milliseconds>(end - start).count());
+    return total_ops / millis;
+}
+
+/*
+writes a row with read_mostly_test's throughput for 1, 2, 4 ... 64 reading threads.
+*/
+template <class T>
+void read_mostly_test_aggregate(int runs, int size = 1000000)
+{
+    std::ofstream output{"results.csv", std::ios_base::app};
+    vector<int> thread_counts = {1, 2, 4, 8, 16, 32, 64};
+    for (int run = 0; run < runs; ++run) {
+        string row = "\nread_mostly_ops_per_ms, \"" + string{type_name<T>()} + "\"";
+        for (int threads : thread_counts) {
+            T testmap{};
+            row += ", " + std::to_string(read_mostly_test(testmap, threads, size));
+        }
+        output << row;
+        cout << row;
+    }
+}
+
+/*
+The end of a group-by: 8 per-thread LP3s that counted size random keys between them get merged into 1.
+threads == 0 merges the way you would without merge_parallel, inserting every element in the first partial.
+returns the time the merge took in milliseconds.
+*/
+inline long int merge_test(int threads, int size)
+{
+    const int partial_n = 8;
+    std::vector<LP3<int, int>> partials(partial_n, LP3<int, int>{});
+    for (int p = 0; p < partial_n; p++) {
+        for (int i = 0; i < size / partial_n; i++) {
+            partials[p][gen_int() % size]++;
+        }
+    }
+    time_point<steady_clock> start = steady_clock::now();
+    if (threads == 0) {
+        for (int p = 1; p < partial_n; p++) {
+            for (auto& kv : partials[p]) {
+                partials[0][kv.first] += kv.second;
+            }
+        }
+    }
+    else {
+        auto merged = merge_parallel(partials, [](int& into, int&& from) { into += from; }, threads);
+    }
+    time_point<steady_clock> end = steady_clock::now();
+    return duration_cast<milliseconds>(end - start).count();
+}
+
+/*
+writes a row with merge_test's time for inserting 1 by 1, then merge_parallel on 1, 2, 4 ... 64 threads.
+*/
+inline void merge_test_aggregate(int runs, int size)
+{
+    std::ofstream output{"results.csv", std::ios_base::app};
+    for (int run = 0; run < runs; ++run) {
+        string row = "\nmerge_ms_insert_then_1_to_64_threads, \"LP3<int, int>\", " + std::to_string(merge_test(0, size));
+        for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+            row += ", " + std::to_string(merge_test(threads, size));
+        }
+        output << row;
+        cout << row;
+    }
+}
+
+/*
+An hourly compaction: age every value of a map with size elements, sum them, and erase the half that got too old.
+threads == 0 does it with the serial loops and the erase_if that erases through iterators.
+returns the time all 3 took in milliseconds.
+*/
+inline long int compaction_test(int threads, int size)
+{
+    LP3<int, int> map;
+    map.reserve(size);
+    for (int i = 0; i < size; i++) {
+        map[i] = gen_int() % 100;
+    }
+    auto too_old = [](const std::pair<const int, int>& kv) { return kv.second >= 51; };
+    volatile long long sum = 0;  // nothing reads it, volatile keeps the summing from being optimized away
+    time_point<steady_clock> start = steady_clock::now();
+    if (threads == 0) {
+        for (auto& kv : map) {
+            kv.second++;
+        }
+        for (auto& kv : map) {
+            sum += kv.second;
+        }
+        erase_if(map, too_old);
+    }
+    else {
+        LP::thread_pool pool(threads);
+        start = steady_clock::now();  // starting the threads is a cost a long running job pays once
+        map.transform_values([](const int&, const int& age) { return age + 1; }, pool);
+        sum = map.reduce(0LL, std::plus<long long>{}, [](const std::pair<const int, int>& kv) { return kv.second; },
+                         pool);
+        map.erase_if(too_old, pool);
+    }
+    time_point<steady_clock> end = steady_clock::now();
+    return duration_cast<milliseconds>(end - start).count();
+}
+
+/*
+writes a row with compaction_test's time for the serial loops, then the pool versions on 1, 2, 4 ... 64 threads.
+*/
+inline void compaction_test_aggregate(int runs, int size)
+{
+    std::ofstream output{"results.csv", std::ios_base::app};
+    for (int run = 0; run < runs; ++run) {
+        string row = "\ncompaction_ms_serial_then_1_to_64_threads, \"LP3<int, int>\", "
+                     + std::to_string(compaction_test(0, size));
+        for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+            row += ", " + std::to_string(compaction_test(threads, size));
+        }
+        output << row;
+        cout << row;
+    }
+}
+
+/*
+writes a row per write percentage, and one for counting_test, with the throughput for 1, 2, 4 ... 64 threads.
+T gets constructed fresh for every run, since the concurrent maps can't be copied.
+*/
+template <class T>
+void concurrent_test_aggregate(int runs, int size = 1000000)
+{
+    std::ofstream output{"results.csv", std::ios_base::app};
+    vector<int> thread_counts = {1, 2, 4, 8, 16, 32, 64};
+    for (int run = 0; run < runs; ++run) {
+        for (int write_percent : {0, 10, 50}) {
+            string row = "\nconcurrent_" + std::to_string(write_percent) + "_percent_writes_ops_per_ms, \"";
+            row += string{type_name<T>()} + "\"";
+            for (int threads : thread_counts) {
+                T testmap{};
+                row += ", " + std::to_string(concurrent_test(testmap, threads, size, write_percent));
+            }
+            output << row;
+            cout << row;
+        }
+        string row = "\nconcurrent_counting_ops_per_ms, \"" + string{type_name<T>()} + "\"";
+        for (int threads : thread_counts) {
+            T testmap{};
+            row += ", " + std::to_string(counting_test(testmap, threads, size));
+        }
+        output << row;
+        cout << row;
+    }
+}
+
+#endif /* CONCURRENT_TESTS_H */
@@ -21,4 +21,6 @@ std::string gen_string();
 
 std::string gen_unsuccesfull_string();
 
+std::string gen_string_of_length(int length);
+
 #endif /* GENERATOR_H */
\ No newline at end of file
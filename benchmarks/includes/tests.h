@@ -6,10 +6,13 @@
 #include <chrono>
 #include <iostream>
 #include <iterator>
+#include <numeric>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 // own
+#include "./bigtype.h"
 #include "./generator.h"
 #include "./prepare.h"
 
@@ -17,6 +20,21 @@ using namespace std::chrono;
 using std::cout;
 using std::vector;
 
+/*
+bytes the map uses per element, for maps that can tell (LP3's memory_usage()), -1 for the others.
+the int/long argument picks the first overload when it compiles
+*/
+template <class T>
+auto bytes_per_element(const T& map, int) -> decltype(static_cast<long int>(map.memory_usage().bytes_per_element()))
+{
+    return static_cast<long int>(map.memory_usage().bytes_per_element());
+}
+template <class T>
+long int bytes_per_element(const T&, long)
+{
+    return -1;
+}
+
 /*
 This is yet again a template function.
 basic functionality is like this:
@@ -31,6 +49,7 @@ basic functionality is like this:
 9. lookup 10k nonexistent keys(nonkeys) and time it
 10. delete 10k keys(sample_keys) and time it
 times are added to the results vector, and that is returned.
+The last entry is bytes per element right after the insertion test, or -1 if the map can't tell.
 
 (4) this step is called because some hashmaps require some extra steps before
 you use them. For example, setting a key that will be the thombstone marker, the
@@ -89,6 +108,7 @@ vector<long int> int_test(int size)
 
     auto insert_time = (duration_cast<nanoseconds>(insert_end - insert_start) - vector_acces_time) / 10000;
     results.push_back(insert_time.count());
+    long int bytes = bytes_per_element(testmap, 0);  // with all keys in, reported after the timings
     // clear all values in here, clear up some memory
     insert_keys.clear();
 
@@ -131,37 +151,57 @@ vector<long int> int_test(int size)
     time_point<steady_clock> iter_end = steady_clock::now();
     auto iter_time = (duration_cast<nanoseconds>(iter_end - iter_start)) / testmap.size();
     results.push_back(iter_time.count());
+    results.push_back(bytes);
     testmap.clear();
     return results;
 }
 
+// the value string_test stores under key: the key itself for string values, a Big filled with its length for Big
+template <class V>
+V value_for(const string& key);
+template <>
+inline string value_for<string>(const string& key)
+{
+    return key;
+}
+template <>
+inline Big value_for<Big>(const string& key)
+{
+    return Big{static_cast<int>(key.size())};
+}
+
 // pretty much the same, but with strings
 // the reason it's split up in 2 functions is because we need other functions to
 // generate the keys, and unfortunately we can't overload based on return type
-template <class T>
-vector<long int> string_test(int size)
+// keys are key_length chars, the keys of the unsuccesful lookups 1 shorter
+// V is the map's value type. With Big (204 bytes), a map that keeps its keys and values together drags value bytes
+// along on every key compare
+template <class T, class V = string>
+vector<long int> string_test(int size, int key_length = 5)
 {
     vector<long int> results;         // insert, lookup, unsuccesful lookup, delete times
     vector<string> sample_keys;  // get a sample of keys to lookup and later delete
+    auto gen_key = [key_length] { return gen_string_of_length(key_length); };
+    const V missing = value_for<V>("");  // no key is empty, so no value is this
 
     // unsuccesful lookup keys
     vector<string> nonkeys(10000);
-    std::generate(nonkeys.begin(), nonkeys.end(), gen_unsuccesfull_string);
+    std::generate(nonkeys.begin(), nonkeys.end(), [key_length] { return gen_string_of_length(key_length - 1); });
 
     // keys for insert test
     vector<string> insert_keys(10000);
-    std::generate(insert_keys.begin(), insert_keys.end(), gen_string);
+    std::generate(insert_keys.begin(), insert_keys.end(), gen_key);
 
     T testmap{};
     prepare(testmap, size);  // do special actions, such as setting the tombstone marker for other, more exotic hashmaps
 
     {  // seperate scope, so all_keys gets destroyed. for good measure, empty it too
         vector<string> all_keys(size - 10000);
-        std::generate(all_keys.begin(), all_keys.end(), gen_string);
+        std::generate(all_keys.begin(), all_keys.end(), gen_key);
         std::sample(all_keys.begin(), all_keys.end(), std::back_inserter(sample_keys), 10000, generator);
 
-        for (auto i : all_keys) {
-            testmap.insert({i, i});
+        for (const auto& i : all_keys) {
+            testmap.insert({i, value_for<V>(i)});
         }
         all_keys.clear();
     }
@@ -176,20 +216,21 @@ vector<long int> string_test(int size)
 
     // insertion test
     time_point<steady_clock> insert_start = steady_clock::now();
-    for (auto key : insert_keys) {
-        testmap.insert({key, key});
+    for (const auto& key : insert_keys) {
+        testmap.insert({key, value_for<V>(key)});
     }
     time_point<steady_clock> insert_end = steady_clock::now();
 
     auto insert_time = (duration_cast<nanoseconds>(insert_end - insert_start) - vector_acces_time) / 10000;
     results.push_back(insert_time.count());
+    long int bytes = bytes_per_element(testmap, 0);  // with all keys in, reported after the timings
     // remove some memory
     insert_keys.clear();
 
     // lookup test
     time_point<steady_clock> lookup_start = steady_clock::now();
-    for (auto key : sample_keys) {
-        if (testmap[key] != key) cout << "WTF";
+    for (const auto& key : sample_keys) {
+        if (testmap[key] == missing) cout << "WTF";
     }
     time_point<steady_clock> lookup_end = steady_clock::now();
     auto lookup_time = (duration_cast<nanoseconds>(lookup_end - lookup_start) - vector_acces_time) / 10000;
@@ -197,8 +238,7 @@ vector<long int> string_test(int size)
 
     // unsuccesful lookup test
     time_point<steady_clock> unlookup_start = steady_clock::now();
-    for (auto key : nonkeys) {
-//        if (testmap[key] == "a") cout << "WTF";
+    for (const auto& key : nonkeys) {
         if (testmap.count(key)) cout << "huh";
     }
     time_point<steady_clock> unlookup_end = steady_clock::now();
@@ -209,7 +249,7 @@ vector<long int> string_test(int size)
 
     // delete test
     time_point<steady_clock> delete_start = steady_clock::now();
-    for (auto key : sample_keys) {
+    for (const auto& key : sample_keys) {
         testmap.erase(key);
     }
 
@@ -217,18 +257,79 @@ vector<long int> string_test(int size)
     auto delete_time = (duration_cast<nanoseconds>(delete_end - delete_start) - vector_acces_time) / 10000;
     results.push_back(delete_time.count());
 
-    //    Iteration time
+    //    Iteration time. Big values aren't looked at, values that aren't looked at shouldn't cost anything
     time_point<steady_clock> iter_start = steady_clock::now();
     auto iter = testmap.begin();
     while (++iter != testmap.end()) {
-        if (iter->second == "a") cout << "WTF";
+        if constexpr (std::is_same<V, string>::value) {
+            if (iter->second == "a") cout << "WTF";
+        }
+        else {
+            if (iter->first == "") cout << "WTF";
+        }
     }
     time_point<steady_clock> iter_end = steady_clock::now();
     auto iter_time = (duration_cast<nanoseconds>(iter_end - iter_start)) / testmap.size();
     results.push_back(iter_time.count());
+    results.push_back(bytes);
 
     testmap.clear();
     return results;
 }
 
+/*
+No timings here, this one measures how clustered the table is after inserting size keys.
+Only works for maps that have probe_length(key) and the bucket interface (LP3).
+sequential = true inserts 0, 1, 2, ..., which the identity hash for ints puts in one long run of buckets.
+otherwise it's the same random keys as int_test.
+results are:
+1. mean buckets examined by a successful lookup, times 100
+2. mean buckets examined by an unsuccessful lookup, times 100
+3. longest run of occupied buckets
+*/
+template <class T>
+vector<long int> cluster_test(int size, bool sequential)
+{
+    vector<long int> results;
+    vector<int> sample_keys;
+    vector<int> nonkeys(10000);
+    std::generate(nonkeys.begin(), nonkeys.end(), gen_unsuccesfull_int);
+
+    T testmap{};
+    {
+        vector<int> all_keys(size);
+        if (sequential) {
+            std::iota(all_keys.begin(), all_keys.end(), 0);
+        }
+        else {
+            std::generate(all_keys.begin(), all_keys.end(), gen_int);
+        }
+        std::sample(all_keys.begin(), all_keys.end(), std::back_inserter(sample_keys), 10000, generator);
+        for (auto i : all_keys) {
+            testmap.insert({i, i});
+        }
+    }
+
+    size_t succ_probes = 0;
+    for (auto key : sample_keys) {
+        succ_probes += testmap.probe_length(key);
+    }
+    results.push_back(100 * succ_probes / sample_keys.size());
+
+    size_t nosucc_probes = 0;
+    for (auto key : nonkeys) {
+        nosucc_probes += testmap.probe_length(key);
+    }
+    results.push_back(100 * nosucc_probes / nonkeys.size());
+
+    long int longest = 0;
+    long int run = 0;
+    for (size_t i = 0; i < testmap.bucket_count(); i++) {
+        run = testmap.bucket_size(i) ? run + 1 : 0;
+        longest = std::max(longest, run);
+    }
+    results.push_back(longest);
+    return results;
+}
+
 #endif /* TESTS_H */
\ No newline at end of file
@@ -0,0 +1,886 @@
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "LPmap3.h"
+
+namespace LP {
+
+    /**
+     * @brief the 2 hashes of a key in CuckooMap. first == EMPTY marks an empty slot
+     */
+    struct Cuckoo_hashes {
+        int32_t first;
+        int32_t second;
+        friend bool operator==(const Cuckoo_hashes& a, const Cuckoo_hashes& b)
+        {
+            return a.first == b.first && a.second == b.second;
+        }
+    };
+
+    /**
+     * @brief the hashes of the 4 slots of a CuckooMap bucket. 32 bytes, so a bucket never straddles a cache line
+     */
+    struct alignas(32) Cuckoo_bucket {
+        static constexpr int slots = 4;
+        Cuckoo_bucket() : slot{{EMPTY, EMPTY}, {EMPTY, EMPTY}, {EMPTY, EMPTY}, {EMPTY, EMPTY}} {};
+        Cuckoo_hashes slot[slots];
+    };
+
+    /**
+     * @brief the tables of CuckooMap's second hash. Independent of default_tabulation(), which does the first
+     */
+    inline const tabulation_table& cuckoo_tabulation()
+    {
+        static const tabulation_table table = make_tabulation(INT32_MAX - 2021);
+        return table;
+    }
+}  // namespace LP
+
+/**
+ * @brief Bucketized cuckoo hash map
+ * @tparam K Key
+ * @tparam V Value
+ * @tparam Hash Hashing function that should be used to hash keys
+ * @tparam Pred equality function to check if keys are equal
+ * @tparam Allocator=std::allocator the allocator
+ *
+ * @details
+ * Every key has 2 buckets of 4 slots, picked by 2 tabulation hashes of all 8 bytes of the user's hash, with 2
+ * independent sets of tables that every map shares (LP::default_tabulation() and LP::cuckoo_tabulation()).
+ * A key is always in one of its 2 buckets or in the stash, so a lookup looks at 8 slots and at most
+ * stash_max stashed keys, no matter how full the table is. That's the point of this map: LP3's probe sequences
+ * have no upper bound, these do.
+ *
+ * Inserting into 2 full buckets searches breadth first for the shortest chain of keys that can each move to their
+ * other bucket, ending in a bucket with an empty slot, and shifts the chain along. If there's no such chain within
+ * max_bfs_nodes buckets, the key goes to the stash. When the stash is full too, the table grows. Growing can't
+ * split up keys whose hashes are equal, so the insert that would make more than 2 * slots + stash_max of them
+ * throws std::overflow_error instead, like HopscotchMap does when more than H keys share a hash.
+ *
+ * Like LP3, the pairs live in a plf::colony, so references stay valid and moving a key between buckets
+ * only moves its hashes and handle. Both hashes are stored, so moving a key never touches the key itself.
+ * Integral keys are tabulation hashed too, the identity hash LP3 uses can't give 2 independent bucket choices.
+ *
+ * bucket_count() counts slots, so load_factor() stays size() / bucket_count().
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>,
+          class Allocator = std::allocator<std::pair<const K, V>>>
+class CuckooMap {
+    using Handle = LP::naive_faster_colony_iter<std::pair<const K, V>, Allocator>;
+    using Pair_elem = std::pair<const K, V>;
+    using plf_iter = typename plf::colony<Pair_elem, Allocator>::iterator;
+    using plf_constiter = typename plf::colony<Pair_elem, Allocator>::const_iterator;
+    using Bucket = LP::Cuckoo_bucket;
+
+    static constexpr int slots = Bucket::slots;
+    static constexpr size_t stash_max = 4;        // stashed keys before the table grows
+    static constexpr size_t max_bfs_nodes = 256;  // buckets the insertion search looks at before giving up
+    static constexpr size_t not_found = SIZE_MAX;
+
+  private:
+    Hash user_hash;
+    Pred is_equal;
+    int inserted_n;
+    size_t bucket_n;
+    uint64_t modulo_help;                                     // faster modulo trick thing, see lemire's fastmod
+    float lf_max;                                             // max loadfactor
+    std::vector<Bucket> hash_store;                           // hashes of the keys in each slot
+    std::vector<Handle> iter_store;                           // kv_pair iterators, slots * bucket_n of them
+    std::vector<std::pair<LP::Cuckoo_hashes, Handle>> stash;  // keys that didn't fit in either bucket
+    const LP::tabulation_table* random_state;                 // tables for the first hash
+    const LP::tabulation_table* random_state_alt;             // tables for the second hash
+    plf::colony<Pair_elem, Allocator> kv_store;
+
+    LP::Cuckoo_hashes hasher(const K& key) const;
+    size_t bucket_of(int32_t hash) const { return LP::home_slot(hash, modulo_help, bucket_n); };
+    size_t other_bucket(const LP::Cuckoo_hashes& hashes, size_t bucket) const;
+    int empty_slot(size_t bucket) const;
+    size_t locate(const K& key, const LP::Cuckoo_hashes& hashes) const;  // slot index, stash after the table
+    Handle& handle_at(size_t pos)
+    {
+        return pos < iter_store.size() ? iter_store[pos] : stash[pos - iter_store.size()].second;
+    };
+    bool try_place(const LP::Cuckoo_hashes& hashes, const Handle& handle);
+    bool inseparable(const LP::Cuckoo_hashes& hashes) const;  // growing can't make room for hashes
+    bool shift_path(size_t first_bucket, size_t second_bucket, size_t& free_bucket, int& free_slot);
+    void place(const LP::Cuckoo_hashes& hashes, const Handle& handle);
+    void unstash(size_t bucket);
+    void rehash(size_t buckets);
+    void reset_buckets(size_t buckets);
+    template <class Key, class... Args>
+    plf_iter store(const LP::Cuckoo_hashes& hashes, Key&& key, Args&&... args);
+
+  public:
+    struct ConstIterator;
+    struct Iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const K, V>;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        plf_iter slave;
+
+      public:
+        Iterator(plf_iter plf) : slave{plf} {};
+        reference operator*() const { return *slave; }
+        pointer operator->() { return slave.operator->(); }
+        Iterator& operator++()
+        {
+            slave++;
+            return *this;
+        };
+        Iterator operator++(int)
+        {
+            Iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        Iterator& operator--()
+        {
+            slave--;
+            return *this;
+        };
+        Iterator operator--(int)
+        {
+            Iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.slave == b.slave; };
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.slave != b.slave; };
+        friend class ConstIterator;
+    };
+
+    struct ConstIterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const K, V>;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        plf_iter slave;
+
+      public:
+        ConstIterator(plf_constiter plf) : slave{plf} {};
+        ConstIterator(Iterator it) : slave{it.slave} {};
+        reference operator*() const { return *slave; }
+        pointer operator->() { return slave.operator->(); }
+        ConstIterator& operator++()
+        {
+            slave++;
+            return *this;
+        };
+        ConstIterator operator++(int)
+        {
+            ConstIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        ConstIterator& operator--()
+        {
+            slave--;
+            return *this;
+        };
+        ConstIterator operator--(int)
+        {
+            ConstIterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        friend bool operator==(const ConstIterator& a, const ConstIterator& b) { return a.slave == b.slave; };
+        friend bool operator!=(const ConstIterator& a, const ConstIterator& b) { return a.slave != b.slave; };
+    };
+
+    Iterator begin() { return Iterator(kv_store.begin()); };
+    Iterator end() { return Iterator(kv_store.end()); };
+    ConstIterator cbegin() const { return ConstIterator(kv_store.cbegin()); };
+    ConstIterator cend() const { return ConstIterator(kv_store.cend()); };
+
+    using value_type = Pair_elem;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using difference_type = typename iterator::difference_type;
+    using size_type = difference_type;
+
+    // constructors and destructors
+    CuckooMap() : CuckooMap(size_t(251)){};
+    explicit CuckooMap(size_t size, const Hash& hash = Hash(), const Pred& equal = Pred());
+    CuckooMap(const CuckooMap& other);
+    CuckooMap(CuckooMap&& other) noexcept;
+    CuckooMap(std::initializer_list<Pair_elem> init);
+    CuckooMap& operator=(const CuckooMap& other);
+    CuckooMap& operator=(CuckooMap&& other) noexcept;
+
+    bool empty() const noexcept { return kv_store.empty(); };
+    int32_t size() const { return inserted_n; };
+
+    // modifiers
+    void clear() noexcept;
+    std::pair<Iterator, bool> insert(const Pair_elem& kv);
+    std::pair<Iterator, bool> insert(Pair_elem&& kv);
+    template <class M>
+    std::pair<Iterator, bool> insert_or_assign(const K& k, M&& obj);
+    template <class... Args>
+    std::pair<Iterator, bool> try_emplace(const K& k, Args&&... args);
+    void swap(CuckooMap& other) noexcept;
+    size_t erase(const K& key);
+    Iterator erase(ConstIterator it);
+    Iterator erase(Iterator it) { return erase(ConstIterator{it}); };
+
+    // lookups
+    V& operator[](const K& k);
+    V& at(const K& k);
+    const V& at(const K& k) const;
+    size_t count(const K& key) const { return locate(key, hasher(key)) != not_found; };
+    bool contains(const K& key) const { return locate(key, hasher(key)) != not_found; };
+    Iterator find(const K& key);
+    ConstIterator find(const K& key) const;
+
+    // bucket interface and hash policy
+    size_t bucket_count() const { return iter_store.size(); };
+    size_t stash_size() const { return stash.size(); };
+    float load_factor() const { return kv_store.size() / (float)iter_store.size(); };
+    float max_load_factor() const { return lf_max; };
+    void max_load_factor(float ml);
+    void rehash();
+    void reserve(int size);
+};
+
+#ifndef CUCKOO_DEF_H
+
+/**
+ * @brief both hashes of key
+ * @details all 8 bytes of the user's hash, tabulation hashed twice with independent tables.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP::Cuckoo_hashes CuckooMap<K, V, Hash, Pred, Allocator>::hasher(const K& key) const
+{
+    const uint64_t full = static_cast<uint64_t>(user_hash(key));
+    return {LP::tabulate(full, *random_state), LP::tabulate(full, *random_state_alt)};
+}
+
+/**
+ * @return the bucket that isn't bucket, out of the 2 a key with these hashes can be in.
+ * bucket itself if both hashes land in the same one
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t CuckooMap<K, V, Hash, Pred, Allocator>::other_bucket(const LP::Cuckoo_hashes& hashes, size_t bucket) const
+{
+    size_t first = bucket_of(hashes.first);
+    return (first == bucket) ? bucket_of(hashes.second) : first;
+}
+
+/**
+ * @return index of an empty slot in bucket, -1 if it's full
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+int CuckooMap<K, V, Hash, Pred, Allocator>::empty_slot(size_t bucket) const
+{
+    for (int i = 0; i < slots; i++) {
+        if (hash_store[bucket].slot[i].first == LP::EMPTY) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @return the slot key is in: bucket * slots + slot for the table, bucket_count() + index for the stash.
+ * not_found if key doesn't exist
+ * @details
+ * both buckets are asked for up front, so the 2 cache misses overlap instead of happening one after the other.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t CuckooMap<K, V, Hash, Pred, Allocator>::locate(const K& key, const LP::Cuckoo_hashes& hashes) const
+{
+    const size_t first = bucket_of(hashes.first);
+    const size_t second = bucket_of(hashes.second);
+    LP::prefetch(&hash_store[second]);
+    for (int i = 0; i < slots; i++) {
+        if (hash_store[first].slot[i] == hashes && is_equal(iter_store[first * slots + i]->first, key)) {
+            return first * slots + i;
+        }
+    }
+    for (int i = 0; i < slots; i++) {
+        if (hash_store[second].slot[i] == hashes && is_equal(iter_store[second * slots + i]->first, key)) {
+            return second * slots + i;
+        }
+    }
+    for (size_t i = 0; i < stash.size(); i++) {
+        if (stash[i].first == hashes && is_equal(stash[i].second->first, key)) {
+            [[unlikely]] return iter_store.size() + i;
+        }
+    }
+    return not_found;
+}
+
+/**
+ * @brief breadth first search for a chain of keys that can each move to their other bucket
+ * @param free_bucket set to first_bucket or second_bucket, whichever got a slot freed up
+ * @param free_slot set to the freed slot
+ * @return false if there's no chain within max_bfs_nodes buckets. Nothing moved in that case
+ * @details
+ * Every bucket is visited once at most, so the keys on the chain are all different, and shifting them from
+ * the end of the chain back to the start keeps every key in one of its own 2 buckets.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool CuckooMap<K, V, Hash, Pred, Allocator>::shift_path(size_t first_bucket, size_t second_bucket,
+                                                        size_t& free_bucket, int& free_slot)
+{
+    struct Node {
+        size_t bucket;
+        size_t parent;    // index in queue, not_found for the 2 starting buckets
+        int parent_slot;  // slot in the parent's bucket whose key moves here
+    };
+    std::vector<Node> queue;
+    queue.reserve(max_bfs_nodes);
+    queue.push_back({first_bucket, not_found, -1});
+    if (second_bucket != first_bucket) {
+        queue.push_back({second_bucket, not_found, -1});
+    }
+    auto visited = [&queue](size_t bucket) {
+        return std::any_of(queue.begin(), queue.end(), [bucket](const Node& n) { return n.bucket == bucket; });
+    };
+
+    for (size_t n = 0; n < queue.size(); n++) {
+        const size_t bucket = queue[n].bucket;
+        for (int s = 0; s < slots; s++) {
+            size_t target = other_bucket(hash_store[bucket].slot[s], bucket);
+            if (target == bucket) {
+                continue;
+            }
+            int target_slot = empty_slot(target);
+            if (target_slot >= 0) {
+                // found one: shift every key on the chain one step along, starting at the end
+                size_t from = n;
+                int from_slot = s;
+                while (true) {
+                    size_t from_bucket = queue[from].bucket;
+                    hash_store[target].slot[target_slot] = hash_store[from_bucket].slot[from_slot];
+                    iter_store[target * slots + target_slot] = iter_store[from_bucket * slots + from_slot];
+                    if (queue[from].parent == not_found) {
+                        hash_store[from_bucket].slot[from_slot].first = LP::EMPTY;
+                        free_bucket = from_bucket;
+                        free_slot = from_slot;
+                        return true;
+                    }
+                    target = from_bucket;
+                    target_slot = from_slot;
+                    from_slot = queue[from].parent_slot;
+                    from = queue[from].parent;
+                }
+            }
+            if (queue.size() < max_bfs_nodes && !visited(target)) {
+                queue.push_back({target, n, s});
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief puts hashes/handle in one of its 2 buckets, making room with shift_path() if both are full
+ * @return false if there was no room to be made
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool CuckooMap<K, V, Hash, Pred, Allocator>::try_place(const LP::Cuckoo_hashes& hashes, const Handle& handle)
+{
+    size_t first = bucket_of(hashes.first);
+    size_t second = bucket_of(hashes.second);
+    size_t bucket = first;
+    int slot = empty_slot(first);
+    if (slot < 0) {
+        bucket = second;
+        slot = empty_slot(second);
+    }
+    if (slot < 0 && !shift_path(first, second, bucket, slot)) {
+        return false;
+    }
+    hash_store[bucket].slot[slot] = hashes;
+    iter_store[bucket * slots + slot] = handle;
+    return true;
+}
+
+/**
+ * @return true if every slot of both of hashes' buckets holds a key with exactly these hashes
+ * @details
+ * keys with the same hashes land in the same 2 buckets at every table size, so growing never splits them up.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool CuckooMap<K, V, Hash, Pred, Allocator>::inseparable(const LP::Cuckoo_hashes& hashes) const
+{
+    for (size_t bucket : {bucket_of(hashes.first), bucket_of(hashes.second)}) {
+        for (int i = 0; i < slots; i++) {
+            if (!(hash_store[bucket].slot[i] == hashes)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief try_place(), then the stash, then growing the table until it fits
+ * @throws std::overflow_error if the stash is full and growing can't help: both buckets are full of keys with the
+ * same hashes as this one (see inseparable()), or the table can't grow anymore.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::place(const LP::Cuckoo_hashes& hashes, const Handle& handle)
+{
+    while (!try_place(hashes, handle)) {
+        if (stash.size() < stash_max) {
+            stash.push_back({hashes, handle});
+            return;
+        }
+        size_t bigger = LP::next_prime(bucket_n);
+        if (inseparable(hashes)) {
+            throw std::overflow_error("too many keys with the same hash");
+        }
+        if (bigger == bucket_n) {
+            throw std::overflow_error("table can't grow anymore");
+        }
+        rehash(bigger);
+    }
+}
+
+/**
+ * @brief moves stashed keys back into the table once bucket has a free slot
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::unstash(size_t bucket)
+{
+    for (size_t i = 0; i < stash.size(); i++) {
+        int slot = empty_slot(bucket);
+        if (slot < 0) {
+            return;
+        }
+        const auto& hashes = stash[i].first;
+        if (bucket_of(hashes.first) == bucket || bucket_of(hashes.second) == bucket) {
+            hash_store[bucket].slot[slot] = hashes;
+            iter_store[bucket * slots + slot] = stash[i].second;
+            stash[i] = stash.back();
+            stash.pop_back();
+            i--;
+        }
+    }
+}
+
+/**
+ * @brief constructs the pair in the colony and gives it a slot
+ * @details if place() throws, the pair is taken out of the colony again so the map stays as it was
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class Key, class... Args>
+typename CuckooMap<K, V, Hash, Pred, Allocator>::plf_iter CuckooMap<K, V, Hash, Pred, Allocator>::store(
+    const LP::Cuckoo_hashes& hashes, Key&& key, Args&&... args)
+{
+    if ((inserted_n + 1) / (float)iter_store.size() > lf_max) {
+        rehash();
+    }
+    auto it = kv_store.emplace(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+    try {
+        place(hashes, Handle(it));
+    }
+    catch (...) {
+        kv_store.erase(it);
+        throw;
+    }
+    inserted_n++;
+    return it;
+}
+
+/**
+ * @brief empty buckets, bucket_n of them
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::reset_buckets(size_t buckets)
+{
+    bucket_n = buckets;
+    modulo_help = fastmod::computeM_s32(buckets);
+    hash_store.assign(buckets, Bucket{});
+    iter_store.assign(buckets * slots, Handle{});
+    stash.clear();
+}
+
+/**
+ * @brief constructor where you specify size
+ * @param size How many objects can be stored without rehash.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+CuckooMap<K, V, Hash, Pred, Allocator>::CuckooMap(size_t size, const Hash& hash, const Pred& equal)
+    : user_hash(hash),
+      is_equal(equal),
+      inserted_n{0},
+      bucket_n{0},
+      modulo_help{0},
+      lf_max{0.9},
+      hash_store{},
+      iter_store{},
+      stash{},
+      random_state{&LP::default_tabulation()},
+      random_state_alt{&LP::cuckoo_tabulation()},
+      kv_store{}
+{
+    reset_buckets(LP::next_prime(size_t(size / (lf_max * slots))));
+}
+
+/**
+ * @details Copy constructor. Handles point into other's colony, so everything gets inserted again
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+CuckooMap<K, V, Hash, Pred, Allocator>::CuckooMap(const CuckooMap& other) : CuckooMap(size_t(other.size()))
+{
+    lf_max = other.lf_max;
+    for (auto it = other.cbegin(); it != other.cend(); it++) {
+        insert(*it);
+    }
+}
+
+/**
+ * @details Move constructor
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+CuckooMap<K, V, Hash, Pred, Allocator>::CuckooMap(CuckooMap&& other) noexcept : CuckooMap(size_t(0))
+{
+    swap(other);
+}
+
+/**
+ * @brief constructor from initializer list
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+CuckooMap<K, V, Hash, Pred, Allocator>::CuckooMap(std::initializer_list<Pair_elem> init) : CuckooMap(init.size())
+{
+    for (const auto& x : init) {
+        insert(x);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+CuckooMap<K, V, Hash, Pred, Allocator>& CuckooMap<K, V, Hash, Pred, Allocator>::operator=(const CuckooMap& other)
+{
+    CuckooMap temp{other};
+    swap(temp);
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+CuckooMap<K, V, Hash, Pred, Allocator>& CuckooMap<K, V, Hash, Pred, Allocator>::operator=(CuckooMap&& other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+/**
+ * @brief deletes all elements, so size is 0. Keeps the bucket count.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::clear() noexcept
+{
+    kv_store.clear();
+    std::fill(hash_store.begin(), hash_store.end(), Bucket{});
+    stash.clear();
+    inserted_n = 0;
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map
+ * @return pair<iterator to map[k], bool is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+std::pair<typename CuckooMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+CuckooMap<K, V, Hash, Pred, Allocator>::insert(const Pair_elem& kv)
+{
+    return try_emplace(kv.first, kv.second);
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map, moving the value
+ * @return pair<iterator to map[k], bool is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+std::pair<typename CuckooMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+CuckooMap<K, V, Hash, Pred, Allocator>::insert(Pair_elem&& kv)
+{
+    return try_emplace(kv.first, std::move(kv.second));
+}
+
+/**
+ * @details assigns obj to map[k] if k exists, inserts (k, obj) otherwise
+ * @return pair<iterator, is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class M>
+std::pair<typename CuckooMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+CuckooMap<K, V, Hash, Pred, Allocator>::insert_or_assign(const K& k, M&& obj)
+{
+    auto hashes = hasher(k);
+    size_t pos = locate(k, hashes);
+    if (pos != not_found) {
+        Handle& handle = handle_at(pos);
+        handle->second = std::forward<M>(obj);
+        return {handle.convert(), false};
+    }
+    return {store(hashes, k, std::forward<M>(obj)), true};
+}
+
+/**
+ * @details constructs V from args in place if k doesn't exist. Does nothing otherwise.
+ * @return pair<iterator, is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class... Args>
+std::pair<typename CuckooMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+CuckooMap<K, V, Hash, Pred, Allocator>::try_emplace(const K& k, Args&&... args)
+{
+    auto hashes = hasher(k);
+    size_t pos = locate(k, hashes);
+    if (pos != not_found) {
+        return {handle_at(pos).convert(), false};
+    }
+    return {store(hashes, k, std::forward<Args>(args)...), true};
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::swap(CuckooMap& other) noexcept
+{
+    std::swap(user_hash, other.user_hash);
+    std::swap(is_equal, other.is_equal);
+    std::swap(inserted_n, other.inserted_n);
+    std::swap(bucket_n, other.bucket_n);
+    std::swap(modulo_help, other.modulo_help);
+    std::swap(lf_max, other.lf_max);
+    std::swap(hash_store, other.hash_store);
+    std::swap(iter_store, other.iter_store);
+    std::swap(stash, other.stash);
+    std::swap(random_state, other.random_state);
+    std::swap(random_state_alt, other.random_state_alt);
+    std::swap(kv_store, other.kv_store);
+}
+
+/**
+ * @brief erase element with key
+ * @return number of erased elements
+ * @details no tombstones needed, the slot is simply empty again. A stashed key that fits in it moves back.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t CuckooMap<K, V, Hash, Pred, Allocator>::erase(const K& key)
+{
+    size_t pos = locate(key, hasher(key));
+    if (pos == not_found) {
+        return 0;
+    }
+    kv_store.erase(handle_at(pos).convert());
+    if (pos < iter_store.size()) {
+        hash_store[pos / slots].slot[pos % slots].first = LP::EMPTY;
+        if (!stash.empty()) {
+            unstash(pos / slots);
+        }
+    }
+    else {
+        stash[pos - iter_store.size()] = stash.back();
+        stash.pop_back();
+    }
+    inserted_n--;
+    return 1;
+}
+
+/**
+ * @param it iterator to element that will be deleted
+ * @return iterator to the element after it
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename CuckooMap<K, V, Hash, Pred, Allocator>::Iterator CuckooMap<K, V, Hash, Pred, Allocator>::erase(
+    ConstIterator it)
+{
+    if (it.slave == kv_store.end()) {
+        return end();
+    }
+    auto next = it.slave;
+    ++next;
+    erase(it.slave->first);
+    return Iterator(next);
+}
+
+/**
+ * @brief access operator, also inserts <key, V{}> if key doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V& CuckooMap<K, V, Hash, Pred, Allocator>::operator[](const K& k)
+{
+    return try_emplace(k).first->second;
+}
+
+/**
+ * @throws std::out_of_range if k doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V& CuckooMap<K, V, Hash, Pred, Allocator>::at(const K& k)
+{
+    size_t pos = locate(k, hasher(k));
+    if (pos != not_found) {
+        return handle_at(pos)->second;
+    }
+    throw std::out_of_range("key doesn't exist");
+}
+
+/**
+ * @throws std::out_of_range if k doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+const V& CuckooMap<K, V, Hash, Pred, Allocator>::at(const K& k) const
+{
+    return const_cast<CuckooMap*>(this)->at(k);
+}
+
+/**
+ * @return iterator to key if exists, end() if it doesn't
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename CuckooMap<K, V, Hash, Pred, Allocator>::Iterator CuckooMap<K, V, Hash, Pred, Allocator>::find(const K& key)
+{
+    size_t pos = locate(key, hasher(key));
+    if (pos != not_found) {
+        return handle_at(pos).convert();
+    }
+    return end();
+}
+
+/**
+ * @return const iterator to key if exists, cend() if it doesn't
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename CuckooMap<K, V, Hash, Pred, Allocator>::ConstIterator CuckooMap<K, V, Hash, Pred, Allocator>::find(
+    const K& key) const
+{
+    return ConstIterator(const_cast<CuckooMap*>(this)->find(key));
+}
+
+/**
+ * @throws std::out_of_range if ml > 1
+ * @details bucketized cuckoo with 2 choices fills up to about 0.95 before inserts start failing and the table grows
+ * anyway, so anything above that mostly buys extra rehashes.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::max_load_factor(float ml)
+{
+    if (ml > 1) {
+        throw std::out_of_range("max loadfactor is 1");
+    }
+    lf_max = ml;
+    if (load_factor() > ml) {
+        rehash(LP::next_prime(size_t(inserted_n / (ml * slots))));
+    }
+}
+
+/**
+ * @brief moves everything into a table of buckets empty buckets. The colony doesn't move, only hashes and handles
+ * @details
+ * if the new table can't hold everything without overflowing the stash, it tries again one prime size bigger.
+ * @throws std::overflow_error if that can't help, see place(). The old table is put back first.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::rehash(size_t buckets)
+{
+    auto old_hashes = std::move(hash_store);
+    auto old_iters = std::move(iter_store);
+    auto old_stash = std::move(stash);
+    while (true) {
+        reset_buckets(buckets);
+        size_t bigger = LP::next_prime(buckets);
+        bool fits = true;
+        bool stuck = false;  // growing won't fit it either
+        auto fit = [&](const LP::Cuckoo_hashes& hashes, const Handle& handle) {
+            if (try_place(hashes, handle)) {
+                return true;
+            }
+            if (stash.size() < stash_max) {
+                stash.push_back({hashes, handle});
+                return true;
+            }
+            stuck = bigger == buckets || inseparable(hashes);
+            return false;
+        };
+        for (size_t b = 0; b < old_hashes.size() && fits; b++) {
+            for (int s = 0; s < slots && fits; s++) {
+                if (old_hashes[b].slot[s].first != LP::EMPTY) {
+                    fits = fit(old_hashes[b].slot[s], old_iters[b * slots + s]);
+                }
+            }
+        }
+        for (size_t i = 0; i < old_stash.size() && fits; i++) {
+            fits = fit(old_stash[i].first, old_stash[i].second);
+        }
+        if (fits) {
+            return;
+        }
+        if (stuck) {
+            bucket_n = old_hashes.size();
+            modulo_help = fastmod::computeM_s32(bucket_n);
+            hash_store = std::move(old_hashes);
+            iter_store = std::move(old_iters);
+            stash = std::move(old_stash);
+            throw std::overflow_error("keys don't fit in any table size");
+        }
+        buckets = bigger;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::rehash()
+{
+    rehash(LP::next_prime(size_t(kv_store.size() / (lf_max * slots))));
+}
+
+/**
+ * @brief make room for size elements without rehashing
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void CuckooMap<K, V, Hash, Pred, Allocator>::reserve(int size)
+{
+    size_t buckets = 1 + size / (lf_max * slots);
+    if (buckets <= bucket_n) {
+        return;
+    }
+    rehash(LP::next_prime(buckets));
+}
+
+/**
+ * @return true if both maps have the same keys, mapped to equal values
+ */
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
+bool operator==(const CuckooMap<K_, V_, Hash_, Pred_, Allocator_>& lhs,
+                const CuckooMap<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+{
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (auto it = lhs.cbegin(); it != lhs.cend(); it++) {
+        auto rhs_it = rhs.find(it->first);
+        if (rhs_it == rhs.cend() || !(rhs_it->second == it->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
+bool operator!=(const CuckooMap<K_, V_, Hash_, Pred_, Allocator_>& lhs,
+                const CuckooMap<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+{
+    return not(lhs == rhs);
+}
+
+#endif  // CUCKOO_DEF_H
+#endif  // CUCKOO_H
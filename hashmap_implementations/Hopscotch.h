@@ -0,0 +1,743 @@
+#ifndef HOPSCOTCH_H
+#define HOPSCOTCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "LPmap3.h"
+
+namespace LP {
+
+    /*
+     * index of the lowest set bit. x can't be 0
+     */
+    inline int lowest_bit(uint32_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(x);
+#else
+        int i = 0;
+        while (!(x & 1u)) {
+            x >>= 1;
+            i++;
+        }
+        return i;
+#endif
+    }
+}  // namespace LP
+
+/**
+ * @brief Hopscotch hashing map
+ * @tparam K Key
+ * @tparam V Value
+ * @tparam Hash Hashing function that should be used to hash keys
+ * @tparam Pred equality function to check if keys are equal
+ * @tparam Allocator=std::allocator the allocator
+ *
+ * @details
+ * Every key is within H = 32 buckets of its home bucket, its neighborhood. Each home bucket has a 32 bit hop bitmap
+ * with bit i set when bucket home + i holds a key that belongs to home. A lookup reads the bitmap and only compares
+ * hashes in the buckets that have their bit set, so it looks at 1 bitmap and at most 32 hashes (2 cache lines),
+ * however full the table is. That keeps it fast at load factors where LP3's clusters get long, the default
+ * max load factor is 0.9.
+ *
+ * An insert takes the first empty bucket after home like LP3 would. If that's outside the neighborhood, it hops
+ * the empty bucket back: some key between the empty bucket and home that can move into it without leaving its own
+ * neighborhood does so, until the empty bucket is close enough. When no key can move, the table grows.
+ * The table has H - 1 buckets after the last home bucket, so neighborhoods never wrap around.
+ *
+ * Keys are tabulation hashed over all 8 bytes the way LP3 hashes non integral keys, integral keys included, with the
+ * tables every map shares (LP::default_tabulation()).
+ * Pairs live in a plf::colony, so references stay valid. hashes, bitmaps and colony handles are in 3 parallel
+ * arrays, like LP3.
+ * Since every bucket in a neighborhood could be holding a key of another home bucket, more than H keys with the
+ * same home can't be stored. Growing splits them up unless their hashes are equal, in which case insert() throws
+ * instead of growing forever.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>,
+          class Allocator = std::allocator<std::pair<const K, V>>>
+class HopscotchMap {
+    using Handle = LP::naive_faster_colony_iter<std::pair<const K, V>, Allocator>;
+    using Pair_elem = std::pair<const K, V>;
+    using plf_iter = typename plf::colony<Pair_elem, Allocator>::iterator;
+    using plf_constiter = typename plf::colony<Pair_elem, Allocator>::const_iterator;
+
+    static constexpr size_t neighborhood = 32;  // H, the number of bits in a hop bitmap
+    static constexpr size_t not_found = SIZE_MAX;
+
+  private:
+    Hash user_hash;
+    Pred is_equal;
+    int inserted_n;
+    size_t home_n;                             // home buckets. hash_store has neighborhood - 1 more buckets
+    uint64_t modulo_help;                      // faster modulo trick thing, see lemire's fastmod
+    float lf_max;                              // max loadfactor
+    std::vector<uint32_t> hop_store;           // hop bitmap per home bucket
+    std::vector<int32_t> hash_store;           // hash of the key in each bucket, EMPTY if there's none
+    std::vector<Handle> iter_store;            // kv_pair iterators, parallel to hash_store
+    const LP::tabulation_table* random_state;  // tables used for hashing
+    plf::colony<Pair_elem, Allocator> kv_store;
+
+    template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool> = true>
+    int32_t hasher(Integral key) const;  // hashes key for integral type
+    template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool> = true>
+    int32_t hasher(const NonIntegral& key) const;  // hashes key for non integral type
+    size_t home_of(int32_t hash) const { return LP::home_slot(hash, modulo_help, home_n); };
+    size_t locate(const K& key, int32_t hash) const;  // bucket of key, or not_found
+    size_t make_room(size_t home);                    // empty bucket in home's neighborhood, or not_found
+    bool try_place(int32_t hash, const Handle& handle);
+    void place(int32_t hash, const Handle& handle);
+    void rehash(size_t size);
+    void reset_buckets(size_t size);
+    template <class Key, class... Args>
+    plf_iter store(int32_t hash, Key&& key, Args&&... args);
+
+  public:
+    struct ConstIterator;
+    struct Iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const K, V>;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        plf_iter slave;
+
+      public:
+        Iterator(plf_iter plf) : slave{plf} {};
+        reference operator*() const { return *slave; }
+        pointer operator->() { return slave.operator->(); }
+        Iterator& operator++()
+        {
+            slave++;
+            return *this;
+        };
+        Iterator operator++(int)
+        {
+            Iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        Iterator& operator--()
+        {
+            slave--;
+            return *this;
+        };
+        Iterator operator--(int)
+        {
+            Iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.slave == b.slave; };
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.slave != b.slave; };
+        friend class ConstIterator;
+    };
+
+    struct ConstIterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const K, V>;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        plf_iter slave;
+
+      public:
+        ConstIterator(plf_constiter plf) : slave{plf} {};
+        ConstIterator(Iterator it) : slave{it.slave} {};
+        reference operator*() const { return *slave; }
+        pointer operator->() { return slave.operator->(); }
+        ConstIterator& operator++()
+        {
+            slave++;
+            return *this;
+        };
+        ConstIterator operator++(int)
+        {
+            ConstIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        ConstIterator& operator--()
+        {
+            slave--;
+            return *this;
+        };
+        ConstIterator operator--(int)
+        {
+            ConstIterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        friend bool operator==(const ConstIterator& a, const ConstIterator& b) { return a.slave == b.slave; };
+        friend bool operator!=(const ConstIterator& a, const ConstIterator& b) { return a.slave != b.slave; };
+    };
+
+    Iterator begin() { return Iterator(kv_store.begin()); };
+    Iterator end() { return Iterator(kv_store.end()); };
+    ConstIterator cbegin() const { return ConstIterator(kv_store.cbegin()); };
+    ConstIterator cend() const { return ConstIterator(kv_store.cend()); };
+
+    using value_type = Pair_elem;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using difference_type = typename iterator::difference_type;
+    using size_type = difference_type;
+
+    // constructors and destructors
+    HopscotchMap() : HopscotchMap(size_t(251)){};
+    explicit HopscotchMap(size_t size, const Hash& hash = Hash(), const Pred& equal = Pred());
+    HopscotchMap(const HopscotchMap& other);
+    HopscotchMap(HopscotchMap&& other) noexcept;
+    HopscotchMap(std::initializer_list<Pair_elem> init);
+    HopscotchMap& operator=(const HopscotchMap& other);
+    HopscotchMap& operator=(HopscotchMap&& other) noexcept;
+
+    bool empty() const noexcept { return kv_store.empty(); };
+    int32_t size() const { return inserted_n; };
+
+    // modifiers
+    void clear() noexcept;
+    std::pair<Iterator, bool> insert(const Pair_elem& kv);
+    std::pair<Iterator, bool> insert(Pair_elem&& kv);
+    template <class M>
+    std::pair<Iterator, bool> insert_or_assign(const K& k, M&& obj);
+    template <class... Args>
+    std::pair<Iterator, bool> try_emplace(const K& k, Args&&... args);
+    void swap(HopscotchMap& other) noexcept;
+    size_t erase(const K& key);
+    Iterator erase(ConstIterator it);
+    Iterator erase(Iterator it) { return erase(ConstIterator{it}); };
+
+    // lookups
+    V& operator[](const K& k);
+    V& at(const K& k);
+    const V& at(const K& k) const;
+    size_t count(const K& key) const { return locate(key, hasher(key)) != not_found; };
+    bool contains(const K& key) const { return locate(key, hasher(key)) != not_found; };
+    Iterator find(const K& key);
+    ConstIterator find(const K& key) const;
+
+    // bucket interface and hash policy
+    size_t bucket_count() const { return home_n; };
+    size_t bucket_size(size_t n) const { return hash_store[n] != LP::EMPTY; };
+    size_t bucket(const K& key) const { return locate(key, hasher(key)); };
+    float load_factor() const { return kv_store.size() / (float)home_n; };
+    float max_load_factor() const { return lf_max; };
+    void max_load_factor(float ml);
+    void rehash();
+    void reserve(int size);
+};
+
+#ifndef HOPSCOTCH_DEF_H
+
+/**
+ * @brief hashes non integral keys, the same way LP3 does
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool>>
+int32_t HopscotchMap<K, V, Hash, Pred, Allocator>::hasher(const NonIntegral& key) const
+{
+    return LP::tabulate(static_cast<uint64_t>(user_hash(key)), *random_state);
+}
+
+/**
+ * @brief integral keys get tabulation hashed too, all 8 bytes of them
+ * @details
+ * LP3's identity hash doesn't work here. Linear probing copes with runs of home buckets that each get more than one
+ * key, hopscotch can't: -k and k - 1 share a home bucket for every table size (fastmod maps negatives to
+ * -(k % size), home_slot flips that), so [-n, n) packs 2 keys per home bucket and no neighborhood of 32 can hold that.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool>>
+int32_t HopscotchMap<K, V, Hash, Pred, Allocator>::hasher(Integral key) const
+{
+    return LP::tabulate(static_cast<uint64_t>(key), *random_state);
+}
+
+/**
+ * @return the bucket key is in, not_found if it isn't
+ * @details only the buckets with their bit set in the home bucket's bitmap get looked at.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t HopscotchMap<K, V, Hash, Pred, Allocator>::locate(const K& key, int32_t hash) const
+{
+    const size_t home = home_of(hash);
+    uint32_t hop = hop_store[home];
+    while (hop) {
+        size_t pos = home + LP::lowest_bit(hop);
+        if (hash_store[pos] == hash && is_equal(iter_store[pos]->first, key)) {
+            return pos;
+        }
+        hop &= hop - 1;
+    }
+    return not_found;
+}
+
+/**
+ * @return an empty bucket within home's neighborhood, not_found if it couldn't make one
+ * @details
+ * finds the first empty bucket after home, and while that's too far away, looks for the key closest to home
+ * (in the H - 1 buckets before the empty one) that is allowed to move into it. Moving that key leaves its old
+ * bucket empty, which is closer to home.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t HopscotchMap<K, V, Hash, Pred, Allocator>::make_room(size_t home)
+{
+    size_t free = home;
+    while (free < hash_store.size() && hash_store[free] != LP::EMPTY) {
+        free++;
+    }
+    if (free == hash_store.size()) {
+        return not_found;
+    }
+    while (free - home >= neighborhood) {
+        bool moved = false;
+        // only home buckets own keys: past home_n there's no hop_store, just room for the last neighborhoods
+        const size_t last = std::min(free, home_n);
+        for (size_t owner = std::max(home, free - (neighborhood - 1)); owner < last && !moved; owner++) {
+            if (hop_store[owner] == 0) {
+                continue;
+            }
+            size_t from = owner + LP::lowest_bit(hop_store[owner]);
+            if (from >= free) {
+                continue;
+            }
+            hash_store[free] = hash_store[from];
+            iter_store[free] = iter_store[from];
+            hash_store[from] = LP::EMPTY;
+            hop_store[owner] ^= (1u << (from - owner)) | (1u << (free - owner));
+            free = from;
+            moved = true;
+        }
+        if (!moved) {
+            return not_found;
+        }
+    }
+    return free;
+}
+
+/**
+ * @brief puts hash/handle in the neighborhood of its home bucket
+ * @return false if there's no room for it
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool HopscotchMap<K, V, Hash, Pred, Allocator>::try_place(int32_t hash, const Handle& handle)
+{
+    const size_t home = home_of(hash);
+    size_t pos = make_room(home);
+    if (pos == not_found) {
+        return false;
+    }
+    hash_store[pos] = hash;
+    iter_store[pos] = handle;
+    hop_store[home] |= 1u << (pos - home);
+    return true;
+}
+
+/**
+ * @brief try_place(), growing the table until it fits
+ * @throws std::overflow_error if it doesn't fit in a table that's less than 1/8 full. That only happens when
+ * more than H keys have the same hash, and growing can't split those up.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::place(int32_t hash, const Handle& handle)
+{
+    while (!try_place(hash, handle)) {
+        if (load_factor() < 0.125) {
+            throw std::overflow_error("too many keys with the same hash");
+        }
+        rehash(LP::next_prime(home_n));
+    }
+}
+
+/**
+ * @brief constructs the pair in the colony and gives it a bucket
+ * @details if place() throws, the pair is taken out of the colony again so the map stays as it was
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class Key, class... Args>
+typename HopscotchMap<K, V, Hash, Pred, Allocator>::plf_iter HopscotchMap<K, V, Hash, Pred, Allocator>::store(
+    int32_t hash, Key&& key, Args&&... args)
+{
+    if ((inserted_n + 1) / (float)home_n > lf_max) {
+        rehash();
+    }
+    auto it = kv_store.emplace(std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+    try {
+        place(hash, Handle(it));
+    }
+    catch (...) {
+        kv_store.erase(it);
+        throw;
+    }
+    inserted_n++;
+    return it;
+}
+
+/**
+ * @brief size home buckets with empty neighborhoods
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::reset_buckets(size_t size)
+{
+    home_n = size;
+    modulo_help = fastmod::computeM_s32(size);
+    hop_store.assign(size, 0);
+    hash_store.assign(size + neighborhood - 1, LP::EMPTY);
+    iter_store.assign(size + neighborhood - 1, Handle{});
+}
+
+/**
+ * @brief constructor where you specify size
+ * @param size How many objects can be stored without rehash.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+HopscotchMap<K, V, Hash, Pred, Allocator>::HopscotchMap(size_t size, const Hash& hash, const Pred& equal)
+    : user_hash(hash),
+      is_equal(equal),
+      inserted_n{0},
+      home_n{0},
+      modulo_help{0},
+      lf_max{0.9},
+      hop_store{},
+      hash_store{},
+      iter_store{},
+      random_state{&LP::default_tabulation()},
+      kv_store{}
+{
+    reset_buckets(LP::next_prime(size_t(size / lf_max)));
+}
+
+/**
+ * @details Copy constructor. Handles point into other's colony, so everything gets inserted again
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+HopscotchMap<K, V, Hash, Pred, Allocator>::HopscotchMap(const HopscotchMap& other)
+    : HopscotchMap(size_t(other.size()))
+{
+    lf_max = other.lf_max;
+    for (auto it = other.cbegin(); it != other.cend(); it++) {
+        insert(*it);
+    }
+}
+
+/**
+ * @details Move constructor
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+HopscotchMap<K, V, Hash, Pred, Allocator>::HopscotchMap(HopscotchMap&& other) noexcept : HopscotchMap(size_t(0))
+{
+    swap(other);
+}
+
+/**
+ * @brief constructor from initializer list
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+HopscotchMap<K, V, Hash, Pred, Allocator>::HopscotchMap(std::initializer_list<Pair_elem> init)
+    : HopscotchMap(init.size())
+{
+    for (const auto& x : init) {
+        insert(x);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+HopscotchMap<K, V, Hash, Pred, Allocator>& HopscotchMap<K, V, Hash, Pred, Allocator>::operator=(
+    const HopscotchMap& other)
+{
+    HopscotchMap temp{other};
+    swap(temp);
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+HopscotchMap<K, V, Hash, Pred, Allocator>& HopscotchMap<K, V, Hash, Pred, Allocator>::operator=(
+    HopscotchMap&& other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+/**
+ * @brief deletes all elements, so size is 0. Keeps the bucket count.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::clear() noexcept
+{
+    kv_store.clear();
+    std::fill(hop_store.begin(), hop_store.end(), 0);
+    std::fill(hash_store.begin(), hash_store.end(), LP::EMPTY);
+    inserted_n = 0;
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map
+ * @return pair<iterator to map[k], bool is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+std::pair<typename HopscotchMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+HopscotchMap<K, V, Hash, Pred, Allocator>::insert(const Pair_elem& kv)
+{
+    return try_emplace(kv.first, kv.second);
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map, moving the value
+ * @return pair<iterator to map[k], bool is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+std::pair<typename HopscotchMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+HopscotchMap<K, V, Hash, Pred, Allocator>::insert(Pair_elem&& kv)
+{
+    return try_emplace(kv.first, std::move(kv.second));
+}
+
+/**
+ * @details assigns obj to map[k] if k exists, inserts (k, obj) otherwise
+ * @return pair<iterator, is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class M>
+std::pair<typename HopscotchMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+HopscotchMap<K, V, Hash, Pred, Allocator>::insert_or_assign(const K& k, M&& obj)
+{
+    int32_t hash = hasher(k);
+    size_t pos = locate(k, hash);
+    if (pos != not_found) {
+        iter_store[pos]->second = std::forward<M>(obj);
+        return {iter_store[pos].convert(), false};
+    }
+    return {store(hash, k, std::forward<M>(obj)), true};
+}
+
+/**
+ * @details constructs V from args in place if k doesn't exist. Does nothing otherwise.
+ * @return pair<iterator, is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class... Args>
+std::pair<typename HopscotchMap<K, V, Hash, Pred, Allocator>::Iterator, bool>
+HopscotchMap<K, V, Hash, Pred, Allocator>::try_emplace(const K& k, Args&&... args)
+{
+    int32_t hash = hasher(k);
+    size_t pos = locate(k, hash);
+    if (pos != not_found) {
+        return {iter_store[pos].convert(), false};
+    }
+    return {store(hash, k, std::forward<Args>(args)...), true};
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::swap(HopscotchMap& other) noexcept
+{
+    std::swap(user_hash, other.user_hash);
+    std::swap(is_equal, other.is_equal);
+    std::swap(inserted_n, other.inserted_n);
+    std::swap(home_n, other.home_n);
+    std::swap(modulo_help, other.modulo_help);
+    std::swap(lf_max, other.lf_max);
+    std::swap(hop_store, other.hop_store);
+    std::swap(hash_store, other.hash_store);
+    std::swap(iter_store, other.iter_store);
+    std::swap(random_state, other.random_state);
+    std::swap(kv_store, other.kv_store);
+}
+
+/**
+ * @brief erase element with key
+ * @return number of erased elements
+ * @details no tombstones, clearing the bucket and its bit is enough.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t HopscotchMap<K, V, Hash, Pred, Allocator>::erase(const K& key)
+{
+    int32_t hash = hasher(key);
+    size_t pos = locate(key, hash);
+    if (pos == not_found) {
+        return 0;
+    }
+    size_t home = home_of(hash);
+    kv_store.erase(iter_store[pos].convert());
+    hash_store[pos] = LP::EMPTY;
+    hop_store[home] &= ~(1u << (pos - home));
+    inserted_n--;
+    return 1;
+}
+
+/**
+ * @param it iterator to element that will be deleted
+ * @return iterator to the element after it
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename HopscotchMap<K, V, Hash, Pred, Allocator>::Iterator HopscotchMap<K, V, Hash, Pred, Allocator>::erase(
+    ConstIterator it)
+{
+    if (it.slave == kv_store.end()) {
+        return end();
+    }
+    auto next = it.slave;
+    ++next;
+    erase(it.slave->first);
+    return Iterator(next);
+}
+
+/**
+ * @brief access operator, also inserts <key, V{}> if key doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V& HopscotchMap<K, V, Hash, Pred, Allocator>::operator[](const K& k)
+{
+    return try_emplace(k).first->second;
+}
+
+/**
+ * @throws std::out_of_range if k doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V& HopscotchMap<K, V, Hash, Pred, Allocator>::at(const K& k)
+{
+    size_t pos = locate(k, hasher(k));
+    if (pos != not_found) {
+        return iter_store[pos]->second;
+    }
+    throw std::out_of_range("key doesn't exist");
+}
+
+/**
+ * @throws std::out_of_range if k doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+const V& HopscotchMap<K, V, Hash, Pred, Allocator>::at(const K& k) const
+{
+    size_t pos = locate(k, hasher(k));
+    if (pos != not_found) {
+        return iter_store[pos]->second;
+    }
+    throw std::out_of_range("key doesn't exist");
+}
+
+/**
+ * @return iterator to key if exists, end() if it doesn't
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename HopscotchMap<K, V, Hash, Pred, Allocator>::Iterator HopscotchMap<K, V, Hash, Pred, Allocator>::find(
+    const K& key)
+{
+    size_t pos = locate(key, hasher(key));
+    if (pos != not_found) {
+        return iter_store[pos].convert();
+    }
+    return end();
+}
+
+/**
+ * @return const iterator to key if exists, cend() if it doesn't
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename HopscotchMap<K, V, Hash, Pred, Allocator>::ConstIterator HopscotchMap<K, V, Hash, Pred, Allocator>::find(
+    const K& key) const
+{
+    size_t pos = locate(key, hasher(key));
+    if (pos != not_found) {
+        Iterator it = iter_store[pos].convert();
+        return {it};
+    }
+    return cend();
+}
+
+/**
+ * @throws std::out_of_range if ml > 1
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::max_load_factor(float ml)
+{
+    if (ml > 1) {
+        throw std::out_of_range("max loadfactor is 1");
+    }
+    lf_max = ml;
+    if (load_factor() > ml) {
+        rehash(LP::next_prime(size_t(inserted_n / ml)));
+    }
+}
+
+/**
+ * @brief moves everything into a table of size home buckets. The colony doesn't move, only hashes and handles
+ * @details if something doesn't fit in its neighborhood, it starts over one prime size bigger.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::rehash(size_t size)
+{
+    auto old_hashes = std::move(hash_store);
+    auto old_iters = std::move(iter_store);
+    while (true) {
+        reset_buckets(size);
+        bool fits = true;
+        for (size_t i = 0; i < old_hashes.size() && fits; i++) {
+            if (old_hashes[i] != LP::EMPTY) {
+                fits = try_place(old_hashes[i], old_iters[i]);
+            }
+        }
+        if (fits) {
+            return;
+        }
+        size = LP::next_prime(size);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::rehash()
+{
+    rehash(LP::next_prime(size_t(kv_store.size() / lf_max)));
+}
+
+/**
+ * @brief make room for size elements without rehashing
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void HopscotchMap<K, V, Hash, Pred, Allocator>::reserve(int size)
+{
+    size_t s = 1 + (size / lf_max);
+    if (s <= home_n) {
+        return;
+    }
+    rehash(LP::next_prime(s));
+}
+
+/**
+ * @return true if both maps have the same keys, mapped to equal values
+ */
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
+bool operator==(const HopscotchMap<K_, V_, Hash_, Pred_, Allocator_>& lhs,
+                const HopscotchMap<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+{
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (auto it = lhs.cbegin(); it != lhs.cend(); it++) {
+        auto rhs_it = rhs.find(it->first);
+        if (rhs_it == rhs.cend() || !(rhs_it->second == it->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
+bool operator!=(const HopscotchMap<K_, V_, Hash_, Pred_, Allocator_>& lhs,
+                const HopscotchMap<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+{
+    return not(lhs == rhs);
+}
+
+#endif  // HOPSCOTCH_DEF_H
+#endif  // HOPSCOTCH_H
@@ -0,0 +1,333 @@
+#ifndef LPARENA_H
+#define LPARENA_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "LPmap3.h"
+
+namespace LP {
+
+    /**
+     * @brief append-only storage for string bytes, in big chunks instead of 1 allocation per string
+     * @details
+     * Views handed out by append() stay valid until clear() or the arena is destroyed, moving the arena included:
+     * chunks never move or grow. Strings longer than a chunk get an allocation of their own.
+     * undo() takes back the last append, which is how a map drops the copy of a key that was already in it.
+     */
+    class string_arena {
+        std::vector<std::unique_ptr<char[]>> chunks;  // chunks.back() is the one being filled
+        std::vector<std::unique_ptr<char[]>> large;   // strings that don't fit in a chunk, 1 allocation each
+        size_t chunk_bytes;
+        size_t used = 0;       // bytes of chunks.back() handed out
+        size_t allocated = 0;  // bytes of all chunks and large strings
+
+      public:
+        static constexpr size_t default_chunk_bytes = 64 * 1024;
+
+        explicit string_arena(size_t chunk_size = default_chunk_bytes) : chunk_bytes{chunk_size} {}
+        string_arena(string_arena&&) noexcept = default;
+        string_arena& operator=(string_arena&&) noexcept = default;
+
+        /**
+         * @return a copy of text in the arena
+         */
+        std::string_view append(std::string_view text)
+        {
+            const size_t n = text.size();
+            char* copy;
+            if (n > chunk_bytes) {
+                large.emplace_back(new char[n]);
+                allocated += n;
+                copy = large.back().get();
+            }
+            else {
+                if (chunks.empty() || used + n > chunk_bytes) {
+                    chunks.emplace_back(new char[chunk_bytes]);
+                    allocated += chunk_bytes;
+                    used = 0;
+                }
+                copy = chunks.back().get() + used;
+                used += n;
+            }
+            std::memcpy(copy, text.data(), n);
+            return {copy, n};
+        }
+
+        /**
+         * @brief gives back the bytes of last, which has to be what the last append() returned
+         * @details the chunk append() may have started for it stays, the next append() fills it
+         */
+        void undo(std::string_view last)
+        {
+            if (last.size() > chunk_bytes) {
+                assert(!large.empty() && large.back().get() == last.data());
+                allocated -= last.size();
+                large.pop_back();
+                return;
+            }
+            assert(!chunks.empty() && chunks.back().get() + used == last.data() + last.size());
+            used -= last.size();
+        }
+
+        void clear()
+        {
+            chunks.clear();
+            large.clear();
+            used = 0;
+            allocated = 0;
+        }
+
+        // bytes the arena allocated, handed out or not
+        size_t bytes() const { return allocated; }
+        size_t chunk_size() const { return chunk_bytes; }
+    };
+
+    /**
+     * @brief gives every distinct string 1 copy and a small id
+     * @details
+     * intern() returns the same id and the same view for equal strings, so the rest of the program can store and
+     * compare 4 byte ids (or views that compare by pointer) instead of strings. Ids count up from 0 in the order
+     * strings were first seen, and view(id) turns them back. Views live as long as the interner.
+     * Not thread safe, like LP3: share one between threads behind a lock.
+     */
+    class string_interner {
+        string_arena arena;
+        LP3<std::string_view, uint32_t> ids;
+        std::vector<std::string_view> views;  // views[id]
+
+      public:
+        struct interned {
+            uint32_t id;
+            std::string_view view;
+        };
+        static constexpr uint32_t not_found = UINT32_MAX;
+
+        explicit string_interner(size_t chunk_size = string_arena::default_chunk_bytes) : arena{chunk_size} {}
+
+        /**
+         * @brief the id and the stored copy of text, made on its first intern()
+         * @details 1 probe: the copy goes in the arena first and is given back if text was already there
+         */
+        interned intern(std::string_view text)
+        {
+            if (views.size() == not_found) {
+                throw std::length_error("string_interner: out of ids");
+            }
+            const std::string_view copy = arena.append(text);
+            auto result = ids.insert({copy, static_cast<uint32_t>(views.size())});
+            if (!result.second) {
+                arena.undo(copy);
+            }
+            else {
+                views.push_back(copy);
+            }
+            return {result.first->second, result.first->first};
+        }
+
+        // the id of text, or not_found if it was never interned
+        uint32_t find(std::string_view text) const
+        {
+            auto it = ids.find(text);
+            return it == ids.cend() ? not_found : it->second;
+        }
+        std::string_view view(uint32_t id) const { return views.at(id); }
+
+        size_t size() const { return views.size(); }
+        // the arena, the id table and the view table
+        size_t bytes() const
+        {
+            return arena.bytes() + ids.memory_usage().total() + views.capacity() * sizeof(std::string_view);
+        }
+    };
+
+}  // namespace LP
+
+/**
+ * @brief LP3 with string keys whose bytes live in an arena owned by the map
+ * @tparam V Value
+ * @tparam Hash Hashing function for std::string_view
+ * @tparam Pred equality function for std::string_view
+ *
+ * @details
+ * An LP3<std::string, V> element holds a 32 byte std::string, and every key longer than the 15 chars that fit
+ * inside it is another allocation somewhere on the heap. Here the elements hold a 16 byte std::string_view, and
+ * the bytes of the keys are copied one after the other into a LP::string_arena. No allocation per key, and keys
+ * inserted together sit together in memory.
+ * Lookups take anything that converts to std::string_view. Iterators and values are LP3's, the keys in them are
+ * views into the arena, valid as long as the map is.
+ *
+ * erase() can't give the bytes of a key back to the arena: they stay until compact() or clear().
+ * wasted_bytes() says how many there are.
+ */
+template <typename V, typename Hash = LP::string_hash, typename Pred = LP::string_equal>
+class LP3Arena {
+    using Map = LP3<std::string_view, V, Hash, Pred>;
+
+    Map map;
+    LP::string_arena arena;
+    size_t erased_bytes = 0;  // key bytes in the arena of elements that were erased
+
+  public:
+    using iterator = typename Map::iterator;
+    using const_iterator = typename Map::const_iterator;
+
+    // constructors and destructors
+    explicit LP3Arena(size_t chunk_size = LP::string_arena::default_chunk_bytes) : map{}, arena{chunk_size} {}
+    // the keys point into arena, a copy would point into the original's
+    LP3Arena(const LP3Arena&) = delete;
+    LP3Arena& operator=(const LP3Arena&) = delete;
+    LP3Arena(LP3Arena&&) = default;
+    LP3Arena& operator=(LP3Arena&&) = default;
+
+    // capacity
+    size_t size() const { return map.size(); };
+    bool empty() const { return map.empty(); };
+
+    // modifiers
+    void clear();
+    template <class M>
+    std::pair<iterator, bool> insert(std::string_view key, M&& value);
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, M&& value);
+    V& operator[](std::string_view key);
+    size_t erase(std::string_view key);
+    iterator erase(const_iterator pos);
+
+    // lookups
+    iterator find(std::string_view key) { return map.find(key); };
+    const_iterator find(std::string_view key) const { return map.find(key); };
+    size_t count(std::string_view key) const { return map.count(key); };
+    V& at(std::string_view key) { return map.at(key); };
+    const V& at(std::string_view key) const { return map.at(key); };
+
+    // iteration
+    iterator begin() { return map.begin(); };
+    iterator end() { return map.end(); };
+    const_iterator cbegin() const { return map.cbegin(); };
+    const_iterator cend() const { return map.cend(); };
+
+    // hash policy and memory
+    void reserve(int size) { map.reserve(size); };
+    void compact();
+    size_t arena_bytes() const { return arena.bytes(); };
+    size_t wasted_bytes() const { return erased_bytes; };
+    // the map's own usage, see LP3::memory_usage(). The keys' bytes are in arena_bytes()
+    LP::Memory_usage memory_usage() const { return map.memory_usage(); };
+};
+
+#ifndef LPARENA_DEF_H
+
+/**
+ * @brief erases every element and frees the arena
+ */
+template <typename V, typename Hash, typename Pred>
+void LP3Arena<V, Hash, Pred>::clear()
+{
+    map.clear();
+    arena.clear();
+    erased_bytes = 0;
+}
+
+/**
+ * @brief inserts (key, value) if key doesn't exist yet
+ * @return iterator to the element with key, and true if it got inserted
+ * @details
+ * key gets copied into the arena before the probe, so the element can point at the copy, and given back if the
+ * key was already there. 1 probe either way.
+ */
+template <typename V, typename Hash, typename Pred>
+template <class M>
+std::pair<typename LP3Arena<V, Hash, Pred>::iterator, bool> LP3Arena<V, Hash, Pred>::insert(std::string_view key,
+                                                                                             M&& value)
+{
+    const std::string_view copy = arena.append(key);
+    auto result = map.insert({copy, std::forward<M>(value)});
+    if (!result.second) {
+        arena.undo(copy);
+    }
+    return result;
+}
+
+/**
+ * @brief assigns value to the element with key, inserts (key, value) if there is none
+ * @return iterator to the element with key, and true if it got inserted
+ */
+template <typename V, typename Hash, typename Pred>
+template <class M>
+std::pair<typename LP3Arena<V, Hash, Pred>::iterator, bool> LP3Arena<V, Hash, Pred>::insert_or_assign(
+    std::string_view key, M&& value)
+{
+    auto it = map.find(key);
+    if (it != map.end()) {
+        it->second = std::forward<M>(value);
+        return {it, false};
+    }
+    return insert(key, std::forward<M>(value));
+}
+
+/**
+ * @return the value of key, default constructed if key wasn't there
+ * @details a hit is 1 probe without copying the key
+ */
+template <typename V, typename Hash, typename Pred>
+V& LP3Arena<V, Hash, Pred>::operator[](std::string_view key)
+{
+    auto it = map.find(key);
+    if (it != map.end()) {
+        return it->second;
+    }
+    return insert(key, V{}).first->second;
+}
+
+/**
+ * @return number of erased elements
+ */
+template <typename V, typename Hash, typename Pred>
+size_t LP3Arena<V, Hash, Pred>::erase(std::string_view key)
+{
+    const size_t erased = map.erase(key);
+    erased_bytes += erased * key.size();
+    return erased;
+}
+
+/**
+ * @return iterator to the element after pos
+ */
+template <typename V, typename Hash, typename Pred>
+typename LP3Arena<V, Hash, Pred>::iterator LP3Arena<V, Hash, Pred>::erase(const_iterator pos)
+{
+    if (pos != map.cend()) {
+        erased_bytes += pos->first.size();
+    }
+    return map.erase(pos);
+}
+
+/**
+ * @brief copies the keys that are still in the map into a new arena, and drops the old one
+ * @details
+ * Worth it once wasted_bytes() is a good part of arena_bytes(). The elements get rebuilt around the new keys,
+ * so it invalidates iterators and references, and needs the new arena and the old one at the same time.
+ */
+template <typename V, typename Hash, typename Pred>
+void LP3Arena<V, Hash, Pred>::compact()
+{
+    LP::string_arena fresh(arena.chunk_size());
+    Map rebuilt(size_t(map.size()));
+    for (auto& kv : map) {
+        rebuilt.insert({fresh.append(kv.first), std::move(kv.second)});
+    }
+    map = std::move(rebuilt);
+    arena = std::move(fresh);
+    erased_bytes = 0;
+}
+
+#endif  // LPARENA_DEF_H
+
+#endif  // LPARENA_H
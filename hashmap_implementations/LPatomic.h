@@ -0,0 +1,492 @@
+#ifndef LPATOMIC_H
+#define LPATOMIC_H
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include "LPmap3.h"
+
+/**
+ * @brief insert-only linear probing map for integral keys and values, that many threads can use without locks
+ * @tparam K integral Key
+ * @tparam V integral Value
+ *
+ * @details
+ * Made for aggregations: lots of threads doing "insert or add" on the same keys. LP3Sharded still takes a lock
+ * per operation, this doesn't take any. A bucket is 2 atomic words, the key and the value:
+ * - a thread claims an empty bucket by compare-exchanging its key from EMPTY_KEY to the key.
+ *   A claimed key never changes again, so probing is LP3's linear probing with plain atomic loads.
+ * - the value is UNSET until the first write lands, everything after that is compare-exchange on the value word.
+ *   fetch_add() is a compare-exchange loop rather than an atomic add, so it can see a resize coming (below).
+ * There's no erase, so there are no tombstones.
+ *
+ * Resizing is cooperative. The thread that pushes the map over its load factor allocates the next table and links
+ * it to the old one. From then on every thread that touches the old table first helps: it takes chunks of
+ * chunk_size buckets, swaps each value for MOVED, and copies the keys that had a value into the next table.
+ * A thread that ends up in a MOVED bucket knows its write didn't land and retries in the next table.
+ * Threads wait (yielding) until the last chunk is copied before they use the next table, so the copy is the only
+ * part that isn't lock-free, and all waiting threads have been working on it.
+ *
+ * Reserved values:
+ * - the largest K marks empty buckets. That key lives in a bucket of its own next to the tables.
+ * - the 2 largest V mark UNSET and MOVED. Writing them, by assignment or by fetch_add overflowing into them,
+ *   throws std::invalid_argument.
+ *
+ * Old tables are kept until the map is destroyed, other threads might still be reading them and there's nothing
+ * here that knows when they're done. Because tables double, that's at most as much memory again as the current one.
+ * for_each() and size() give an exact answer only when no other thread is writing.
+ */
+template <typename K, typename V>
+class LP3Atomic {
+    static_assert(std::is_integral<K>::value && std::is_integral<V>::value, "LP3Atomic only stores integral types");
+
+    static constexpr K EMPTY_KEY = std::numeric_limits<K>::max();
+    static constexpr V UNSET = std::numeric_limits<V>::max();
+    static constexpr V MOVED = std::numeric_limits<V>::max() - 1;
+    static constexpr size_t chunk_size = 4096;  // buckets a resizing thread copies at a time
+    static constexpr float lf_max = 0.5;
+
+    struct Bucket {
+        std::atomic<K> key{EMPTY_KEY};
+        std::atomic<V> value{UNSET};
+    };
+
+    struct Table {
+        size_t size;
+        uint64_t modulo_help;
+        size_t max_elements;
+        size_t chunk_n;
+        std::unique_ptr<Bucket[]> buckets;
+        std::atomic<Table*> next{nullptr};      // the table this one is being / has been copied to
+        std::atomic<bool> allocating{false};    // a thread is allocating next
+        std::atomic<size_t> chunks_claimed{0};  // chunks handed out to copying threads
+        std::atomic<size_t> chunks_copied{0};
+
+        explicit Table(size_t size);
+        ~Table() { delete next.load(); }  // the first table owns the whole chain
+    };
+
+    enum class Outcome { MOVED_ON, UNCHANGED, WRITTEN, INSERTED };
+
+    std::unique_ptr<Table> first;
+    mutable std::atomic<Table*> current;  // mutable: lookups help with resizes too
+    mutable Bucket empty_key_bucket;
+    std::atomic<size_t> elements;
+
+    static int32_t hash(const K& key);
+    static Bucket* locate(Table* table, const K& key, bool claim, bool& full);
+    static void check_value(const V& value);
+    template <class Op>
+    static Outcome update_bucket(Bucket& bucket, Op op);
+
+    template <class Op>
+    void access(const K& key, bool claim, Op op) const;
+    void grow(Table* table, size_t min_elements);
+    Table* finish_resize(Table* table) const;
+
+  public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+
+    // constructors and destructors
+    explicit LP3Atomic(size_t size = 0);
+    LP3Atomic(const LP3Atomic&) = delete;
+    LP3Atomic& operator=(const LP3Atomic&) = delete;
+
+    // capacity
+    size_t size() const { return elements.load(std::memory_order_relaxed); };
+    bool empty() const { return size() == 0; };
+
+    // modifiers
+    bool insert(const value_type& kv);
+    bool insert_or_assign(const K& k, const V& obj);
+    V fetch_add(const K& k, const V& delta);
+    bool compare_exchange(const K& k, V& expected, const V& desired);
+
+    // lookups
+    bool find(const K& key, V& out) const;
+    V at(const K& key) const;
+    size_t count(const K& key) const;
+    bool contains(const K& key) const { return count(key) == 1; };
+
+    // iteration
+    template <class F>
+    void for_each(F f) const;
+
+    // hash policy
+    size_t bucket_count() const { return current.load(std::memory_order_acquire)->size; };
+    float load_factor() const { return static_cast<float>(size()) / bucket_count(); };
+    float max_load_factor() const { return lf_max; };
+    void reserve(size_t size);
+};
+
+#ifndef LPATOMIC_DEF_H
+
+/**
+ * @param size number of buckets, gets rounded up to a prime like LP3's
+ */
+template <typename K, typename V>
+LP3Atomic<K, V>::Table::Table(size_t size)
+    : size{LP::next_prime(size)},
+      modulo_help{fastmod::computeM_s32(this->size)},
+      max_elements{static_cast<size_t>(this->size * lf_max)},
+      chunk_n{(this->size + chunk_size - 1) / chunk_size},
+      buckets{new Bucket[this->size]}
+{
+}
+
+/**
+ * @details
+ * identity like LP3 for integers, with the top half of 64 bit keys folded in so they still reach every bucket
+ */
+template <typename K, typename V>
+int32_t LP3Atomic<K, V>::hash(const K& key)
+{
+    uint64_t bits = static_cast<uint64_t>(key);
+    return static_cast<int32_t>(bits ^ (bits >> 32));
+}
+
+/**
+ * @brief linear probing for key, claiming the first empty bucket when claim is true
+ * @param full set to true when every bucket was looked at
+ * @return key's bucket, nullptr if it isn't in the table (or the table is full)
+ */
+template <typename K, typename V>
+typename LP3Atomic<K, V>::Bucket* LP3Atomic<K, V>::locate(Table* table, const K& key, bool claim, bool& full)
+{
+    size_t pos = LP::home_slot(hash(key), table->modulo_help, table->size);
+    for (size_t i = 0; i < table->size; i++) {
+        Bucket& bucket = table->buckets[pos];
+        K found = bucket.key.load(std::memory_order_acquire);
+        if (found == EMPTY_KEY) {
+            if (!claim) {
+                return nullptr;
+            }
+            if (bucket.key.compare_exchange_strong(found, key, std::memory_order_acq_rel)) {
+                return &bucket;
+            }
+            // lost the race for this bucket, found now holds the winner's key
+        }
+        if (found == key) {
+            return &bucket;
+        }
+        pos = (pos + 1 == table->size) ? 0 : pos + 1;
+    }
+    full = true;
+    return nullptr;
+}
+
+/**
+ * @throws std::invalid_argument if value is one of the 2 values the map reserves
+ */
+template <typename K, typename V>
+void LP3Atomic<K, V>::check_value(const V& value)
+{
+    if (value == UNSET || value == MOVED) {
+        throw std::invalid_argument("LP3Atomic reserves the 2 largest values of V");
+    }
+}
+
+/**
+ * @brief compare-exchange loop on bucket's value
+ * @param op bool(V old, bool present, V& desired), returns false to leave the value alone.
+ * Can be called more than once when other threads write the same bucket in between.
+ * @return MOVED_ON if the bucket got copied to the next table, so nothing was written
+ */
+template <typename K, typename V>
+template <class Op>
+typename LP3Atomic<K, V>::Outcome LP3Atomic<K, V>::update_bucket(Bucket& bucket, Op op)
+{
+    V old = bucket.value.load(std::memory_order_acquire);
+    while (true) {
+        if (old == MOVED) {
+            return Outcome::MOVED_ON;
+        }
+        bool present = old != UNSET;
+        V desired;
+        if (!op(present ? old : V{}, present, desired)) {
+            return Outcome::UNCHANGED;
+        }
+        check_value(desired);
+        if (bucket.value.compare_exchange_weak(old, desired, std::memory_order_acq_rel)) {
+            return present ? Outcome::WRITTEN : Outcome::INSERTED;
+        }
+    }
+}
+
+/**
+ * @brief finds key's bucket (claiming one if claim is true) in the newest table and runs op on it
+ * @details
+ * op doesn't run at all when key isn't in the map and claim is false.
+ * Every table that has a next table is helped along and skipped. A miss only counts when the table it happened in
+ * still had no next table afterwards, otherwise the key could have been inserted in the next one in the meantime.
+ */
+template <typename K, typename V>
+template <class Op>
+void LP3Atomic<K, V>::access(const K& key, bool claim, Op op) const
+{
+    auto self = const_cast<LP3Atomic*>(this);  // only inserts write, and those aren't const
+    if (key == EMPTY_KEY) {
+        if (update_bucket(empty_key_bucket, op) == Outcome::INSERTED) {
+            self->elements.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    Table* table = current.load(std::memory_order_acquire);
+    while (true) {
+        if (table->next.load(std::memory_order_acquire) != nullptr) {
+            table = finish_resize(table);
+            continue;
+        }
+        bool full = false;
+        Bucket* bucket = locate(table, key, claim, full);
+        if (bucket == nullptr) {
+            if (full) {
+                self->grow(table, 0);
+                continue;
+            }
+            if (table->next.load(std::memory_order_acquire) != nullptr) {
+                continue;
+            }
+            return;
+        }
+        Outcome outcome = update_bucket(*bucket, op);
+        if (outcome == Outcome::MOVED_ON) {
+            continue;
+        }
+        if (outcome == Outcome::INSERTED
+            && self->elements.fetch_add(1, std::memory_order_relaxed) + 1 > table->max_elements) {
+            self->grow(table, 0);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief links a bigger table to table, unless another thread already did
+ * @param min_elements the new table should fit at least this many elements
+ * @details only 1 thread allocates, the others wait for it, then everyone copies.
+ */
+template <typename K, typename V>
+void LP3Atomic<K, V>::grow(Table* table, size_t min_elements)
+{
+    bool expected = false;
+    if (table->allocating.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        size_t new_size = std::max(table->size * 2, static_cast<size_t>(min_elements / lf_max) + 1);
+        table->next.store(new Table(new_size), std::memory_order_release);
+    }
+    else {
+        while (table->next.load(std::memory_order_acquire) == nullptr) {
+            std::this_thread::yield();
+        }
+    }
+    finish_resize(table);
+}
+
+/**
+ * @brief helps copy table to its next table, and waits until all of it is copied
+ * @return the next table
+ * @details
+ * Swapping a value for MOVED and copying it happen in the same chunk, and nobody uses the next table before every
+ * chunk is done, so the next table never sees a write that the copy could overwrite.
+ * A key claimed in table after its bucket got copied has an UNSET value that nobody copies: its writer sees MOVED
+ * and writes to the next table instead.
+ */
+template <typename K, typename V>
+typename LP3Atomic<K, V>::Table* LP3Atomic<K, V>::finish_resize(Table* table) const
+{
+    Table* next = table->next.load(std::memory_order_acquire);
+    size_t chunk;
+    while ((chunk = table->chunks_claimed.fetch_add(1, std::memory_order_relaxed)) < table->chunk_n) {
+        size_t end = std::min(table->size, (chunk + 1) * chunk_size);
+        for (size_t pos = chunk * chunk_size; pos < end; pos++) {
+            Bucket& bucket = table->buckets[pos];
+            V value = bucket.value.exchange(MOVED, std::memory_order_acq_rel);
+            if (value == UNSET) {
+                continue;
+            }
+            bool full = false;
+            Bucket* copy = locate(next, bucket.key.load(std::memory_order_acquire), true, full);
+            copy->value.store(value, std::memory_order_release);
+        }
+        table->chunks_copied.fetch_add(1, std::memory_order_acq_rel);
+    }
+    while (table->chunks_copied.load(std::memory_order_acquire) < table->chunk_n) {
+        std::this_thread::yield();
+    }
+    current.compare_exchange_strong(table, next, std::memory_order_acq_rel);
+    return next;
+}
+
+/**
+ * @param size starting number of buckets
+ * @details LP3 draws a tabulation state here, this map doesn't have one, so construction is thread safe
+ */
+template <typename K, typename V>
+LP3Atomic<K, V>::LP3Atomic(size_t size) : first{new Table(size)}, current{first.get()}, empty_key_bucket{}, elements{0}
+{
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map
+ * @return true if it got inserted
+ */
+template <typename K, typename V>
+bool LP3Atomic<K, V>::insert(const value_type& kv)
+{
+    bool inserted = false;
+    access(kv.first, true, [&](V, bool present, V& desired) {
+        inserted = !present;
+        desired = kv.second;
+        return !present;
+    });
+    return inserted;
+}
+
+/**
+ * @details assigns obj to map[k] if k exists, inserts (k, obj) otherwise
+ * @return true if it got inserted
+ */
+template <typename K, typename V>
+bool LP3Atomic<K, V>::insert_or_assign(const K& k, const V& obj)
+{
+    bool inserted = false;
+    access(k, true, [&](V, bool present, V& desired) {
+        inserted = !present;
+        desired = obj;
+        return true;
+    });
+    return inserted;
+}
+
+/**
+ * @brief adds delta to the value of k, inserting (k, delta) if k doesn't exist
+ * @return the value before the add, V{} if k didn't exist
+ */
+template <typename K, typename V>
+V LP3Atomic<K, V>::fetch_add(const K& k, const V& delta)
+{
+    V before{};
+    access(k, true, [&](V old, bool, V& desired) {
+        before = old;
+        desired = old + delta;
+        return true;
+    });
+    return before;
+}
+
+/**
+ * @brief sets the value of k to desired if it's equal to expected
+ * @param expected gets the current value when they're not equal
+ * @return true if desired got stored, false if the value was different or k doesn't exist
+ */
+template <typename K, typename V>
+bool LP3Atomic<K, V>::compare_exchange(const K& k, V& expected, const V& desired)
+{
+    bool exchanged = false;
+    access(k, false, [&](V old, bool present, V& next) {
+        exchanged = present && old == expected;
+        if (present && !exchanged) {
+            expected = old;
+        }
+        next = desired;
+        return exchanged;
+    });
+    return exchanged;
+}
+
+/**
+ * @param out gets the value if key exists, isn't touched otherwise
+ * @return true if key exists
+ */
+template <typename K, typename V>
+bool LP3Atomic<K, V>::find(const K& key, V& out) const
+{
+    bool found = false;
+    access(key, false, [&](V old, bool present, V&) {
+        if (present) {
+            out = old;
+        }
+        found = present;
+        return false;
+    });
+    return found;
+}
+
+/**
+ * @return value of key
+ * @throws std::out_of_range if key doesn't exist
+ */
+template <typename K, typename V>
+V LP3Atomic<K, V>::at(const K& key) const
+{
+    V value;
+    if (!find(key, value)) {
+        throw std::out_of_range("key not found");
+    }
+    return value;
+}
+
+/**
+ * @return 1 if key exists, 0 otherwise
+ */
+template <typename K, typename V>
+size_t LP3Atomic<K, V>::count(const K& key) const
+{
+    V value;
+    return find(key, value);
+}
+
+/**
+ * @brief calls f(K, V) for every element of the newest table
+ * @details exact only while no other thread writes, since it reads the buckets one at a time
+ */
+template <typename K, typename V>
+template <class F>
+void LP3Atomic<K, V>::for_each(F f) const
+{
+    Table* table = current.load(std::memory_order_acquire);
+    while (table->next.load(std::memory_order_acquire) != nullptr) {
+        table = finish_resize(table);
+    }
+    for (size_t pos = 0; pos < table->size; pos++) {
+        V value = table->buckets[pos].value.load(std::memory_order_acquire);
+        if (value != UNSET && value != MOVED) {
+            f(table->buckets[pos].key.load(std::memory_order_relaxed), value);
+        }
+    }
+    V value = empty_key_bucket.value.load(std::memory_order_acquire);
+    if (value != UNSET) {
+        f(EMPTY_KEY, value);
+    }
+}
+
+/**
+ * @brief grows the map until size elements fit without another resize
+ * @details safe to call while other threads use the map, they help copy like with any other resize
+ */
+template <typename K, typename V>
+void LP3Atomic<K, V>::reserve(size_t size)
+{
+    while (true) {
+        Table* table = current.load(std::memory_order_acquire);
+        if (table->next.load(std::memory_order_acquire) != nullptr) {
+            finish_resize(table);
+        }
+        else if (table->max_elements >= size) {
+            return;
+        }
+        else {
+            grow(table, size);
+        }
+    }
+}
+
+#endif  // LPATOMIC_DEF_H
+#endif  // LPATOMIC_H
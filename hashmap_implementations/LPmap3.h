@@ -2,15 +2,32 @@
 #define LP33_H
 
 #include <algorithm>
+#include <chrono>
 #import <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iterator>
+#include <memory>
+#include <new>
 #include <numeric>
 #include <random>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "LPpool.h"
+#include "LPstats.h"
+#include "LPstring.h"
+#include "LPtrace.h"
 #include "fastmod.h"
 #include "plf_colony.h"
+#ifdef __AVX2__
+#    include <immintrin.h>
+#endif
+#ifdef LP3_USDT
+#    include <sys/sdt.h>
+#endif
 
 namespace LP {
 
@@ -45,7 +62,7 @@ namespace LP {
     inline size_t next_prime(const size_t& n)
     {
         size_t next = n;
-        for (const int x : prime_sizes) {
+        for (const size_t x : prime_sizes) {
             if (x > n) {
                 next = x;
                 break;
@@ -54,6 +71,16 @@ namespace LP {
         return next;
     }
 
+    /*
+     * asks for the cache line holding addr while we do other work. no-op on compilers without the builtin
+     */
+    inline void prefetch(const void* addr)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(addr);
+#endif
+    }
+
     /**
      * @brief simple struct for passing around info needed (existence, expected/real position, and hash) when probing
      * @details
@@ -75,8 +102,85 @@ namespace LP {
         int hash;
     };
 
+    /**
+     * @brief home position of a hash in a table of size buckets
+     * @param helper fastmod::computeM_s32(size)
+     * @details integral keys can have negative hashes, which fastmod_s32 maps to negative positions
+     */
+    inline size_t home_slot(int32_t hash, uint64_t helper, size_t size)
+    {
+        int32_t pos = fastmod::fastmod_s32(hash, helper, size);
+        return (pos < 0) ? ~pos : pos;
+    }
+
+    /*
+     * Probing policies for LP3.
+     * A policy gives LP3 the sequence of buckets to look at for a hash, starting at the home position:
+     * - step(hash, size) is computed once per probe and is passed to every next() call
+     * - next(pos, i, step, size) gives the bucket to look at after pos, i being the number of steps taken so far
+     * - max_load is the highest max_load_factor for which the policy is guaranteed to find an empty bucket
+     * Everything is static and inline, so the linear one compiles to the same pos++ LP3 always had.
+     */
+
+    /**
+     * @brief pos, pos+1, pos+2, ...
+     * @details best cache behaviour, but keys with neighbouring home positions (sequential integers with the
+     * identity hash, for example) pile up into long clusters.
+     */
+    struct linear_probe {
+        static constexpr float max_load = 1;
+        static size_t step(int32_t /*hash*/, size_t /*size*/) { return 1; }
+        static size_t next(size_t pos, size_t /*i*/, size_t /*step*/, size_t size)
+        {
+            pos++;
+            return (pos >= size) ? pos - size : pos;
+        }
+    };
+
+    /**
+     * @brief pos, pos+1, pos+4, pos+9, ...
+     * @details
+     * Breaks up primary clustering. With a prime table size the first (size+1)/2 probes are all different buckets,
+     * so an empty bucket is only guaranteed to be found when at most half the table is in use. Hence max_load 0.5.
+     */
+    struct quadratic_probe {
+        static constexpr float max_load = 0.5;
+        static size_t step(int32_t /*hash*/, size_t /*size*/) { return 1; }
+        static size_t next(size_t pos, size_t i, size_t /*step*/, size_t size)
+        {
+            pos += 2 * (i % size) + 1;  // (i+1)^2 - i^2
+            while (pos >= size) {
+                pos -= size;
+            }
+            return pos;
+        }
+    };
+
+    /**
+     * @brief pos, pos+s, pos+2s, ... with s derived from the hash
+     * @details
+     * Keys that share a home position still go their own way, so there's neither primary nor secondary clustering.
+     * s is in [1, size-1], and since the table sizes are prime every s visits every bucket.
+     * The hash gets multiplied by a constant first, so the identity hashed integers don't all get the same s.
+     */
+    struct double_hash_probe {
+        static constexpr float max_load = 1;
+        static size_t step(int32_t hash, size_t size)
+        {
+            uint32_t mixed = static_cast<uint32_t>(hash) * 0x9E3779B1u;
+            return 1 + ((static_cast<uint64_t>(mixed) * (size - 1)) >> 32);
+        }
+        static size_t next(size_t pos, size_t /*i*/, size_t step, size_t size)
+        {
+            pos += step;
+            return (pos >= size) ? pos - size : pos;
+        }
+    };
+
     /**
      * @brief Alternative to plf::colony::iterator
+     * @tparam T element type stored in the colony
+     * @tparam Allocator the colony's allocator
      * @details
      * This is a way to store the plf::colony::iterator.
      * This is done for 2 reasons:
@@ -88,15 +192,14 @@ namespace LP {
      * and I can at most remove 4 bytes with this. group type isn't always within 32bit max of elem_type.
      * I'd have to shave off some bits from the hash in the bucket interface instead.
      */
-    template <typename K, typename V, class Allocator = std::allocator<std::pair<const K, V>>>
+    template <typename T, class Allocator = std::allocator<T>>
     class naive_faster_colony_iter {  // saving a reinterpret cast, giving me  a 20ns speedup
-        using Pair_elem = std::pair<const K, V>;
-        using iter = typename plf::colony<Pair_elem, Allocator>::iterator;
-        using plf_constiter = typename plf::colony<Pair_elem, Allocator>::const_iterator;
-        using group_type = typename plf::colony<Pair_elem>::group_pointer_type;
-        using skipfield_type = typename plf::colony<Pair_elem>::skipfield_pointer_type;
-        using elem_type = typename plf::colony<Pair_elem>::aligned_pointer_type;
-        Pair_elem* elem;
+        using iter = typename plf::colony<T, Allocator>::iterator;
+        using plf_constiter = typename plf::colony<T, Allocator>::const_iterator;
+        using group_type = typename plf::colony<T, Allocator>::group_pointer_type;
+        using skipfield_type = typename plf::colony<T, Allocator>::skipfield_pointer_type;
+        using elem_type = typename plf::colony<T, Allocator>::aligned_pointer_type;
+        T* elem;
         group_type group;
         skipfield_type skipfield;
 
@@ -106,7 +209,7 @@ namespace LP {
          * @param iter plf::colony::iterator
          */
         naive_faster_colony_iter(iter& iter)
-            : elem{reinterpret_cast<Pair_elem*>(iter.element_pointer)},
+            : elem{reinterpret_cast<T*>(iter.element_pointer)},
               group{iter.group_pointer},
               skipfield{iter.skipfield_pointer} {};
         /**
@@ -123,25 +226,187 @@ namespace LP {
          * pointer to member
          * @return
          */
-        Pair_elem* operator->() const { return elem; }
+        T* operator->() const { return elem; }
     };
     constexpr int32_t DELETED = -1;
     constexpr int32_t EMPTY = -2;
     /**
-     *  @brief  wrapper for storing hashes and std::pair<K, V>*
-     *  @tparam  K Key
-     *  @tparam V Value
+     * @brief fixed size array that starts out as all zero bytes, for LP3's bucket arrays
+     * @tparam T trivially copyable, and all zero bytes has to be a valid T
+     * @details
+     * std::vector writes every element when it's created. This gets its memory from calloc, which for big arrays
+     * maps fresh pages from the OS that are zero already and doesn't write anything. Pages only get faulted in
+     * when a bucket on them gets written, so reserving a huge table is O(1) and a sparsely filled one only costs
+     * the pages it uses.
+     */
+    template <class T>
+    class zeroed_array {
+        static_assert(std::is_trivially_copyable<T>::value, "zeroed_array copies with memcpy");
+        T* elems = nullptr;
+        size_t n = 0;
+
+      public:
+        zeroed_array() = default;
+        explicit zeroed_array(size_t size) : elems{static_cast<T*>(std::calloc(size, sizeof(T)))}, n{size}
+        {
+            if (elems == nullptr && size != 0) {
+                throw std::bad_alloc();
+            }
+        }
+        zeroed_array(const zeroed_array& other) : zeroed_array(other.n)
+        {
+            if (n != 0) {
+                std::memcpy(static_cast<void*>(elems), other.elems, n * sizeof(T));
+            }
+        }
+        zeroed_array(zeroed_array&& other) noexcept : elems{other.elems}, n{other.n}
+        {
+            other.elems = nullptr;
+            other.n = 0;
+        }
+        zeroed_array& operator=(zeroed_array other) noexcept
+        {
+            std::swap(elems, other.elems);
+            std::swap(n, other.n);
+            return *this;
+        }
+        ~zeroed_array() { std::free(elems); }
+
+        size_t size() const { return n; }
+        size_t max_size() const { return SIZE_MAX / sizeof(T); }
+        T& operator[](size_t i) { return elems[i]; }
+        const T& operator[](size_t i) const { return elems[i]; }
+        T* begin() { return elems; }
+        T* end() { return elems + n; }
+        /**
+         * @brief grows or shrinks the array, keeping the elements that fit
+         * @param zero_new whether the added elements should be zero. Leave them alone if nothing reads them unwritten
+         * @details realloc moves big blocks with mremap, so the old and the new array never both exist in full
+         */
+        void resize(size_t size, bool zero_new = true)
+        {
+            if (size == 0) {
+                std::free(elems);
+                elems = nullptr;
+                n = 0;
+                return;
+            }
+            T* resized = static_cast<T*>(std::realloc(static_cast<void*>(elems), size * sizeof(T)));
+            if (resized == nullptr) {
+                throw std::bad_alloc();
+            }
+            if (zero_new && size > n) {
+                std::memset(static_cast<void*>(resized + n), 0, (size - n) * sizeof(T));
+            }
+            elems = resized;
+            n = size;
+        }
+        // back to all zero bytes
+        void zero()
+        {
+            if (n != 0) {
+                std::memset(static_cast<void*>(elems), 0, n * sizeof(T));
+            }
+        }
+    };
+    /**
+     * @brief what LP3 keeps in its colony: the element, and the index of the bucket whose handle points at it
+     * @details
+     * the back reference lets erase(iterator) tombstone the bucket without hashing and probing the key again,
+     * and copies of a map take the table over as is. rehash() keeps it current.
+     */
+    template <class Pair>
+    struct Bucket_node {
+        Pair kv;
+        uint32_t bucket;
+
+        template <class... Args>
+        explicit Bucket_node(size_t bucket_, Args&&... args)
+            : kv(std::forward<Args>(args)...), bucket{static_cast<uint32_t>(bucket_)}
+        {
+        }
+    };
+    /**
+     * @brief how much memory an LP3 uses, and on what. see LP3::memory_usage()
+     */
+    struct Memory_usage {
+        size_t hash_store_bytes;    // hashes
+        size_t stamps_bytes;        // generation stamps, 1 byte per bucket
+        size_t iter_store_bytes;    // handles to the elements
+        size_t random_state_bytes;  // tabulation tables of its own, 0 while it uses LP::default_tabulation()
+        size_t colony_bytes;        // everything the colony allocated, group headers and skipfields included
+        size_t colony_groups;       // groups with elements in them
+        size_t reserved_groups;     // empty groups the colony kept around for later inserts
+        size_t colony_capacity;     // element slots in all groups
+        size_t live_slots;          // elements
+        size_t erased_slots;        // holes left by erase(), filled again by the next inserts
+        size_t skipfield_bytes;     // part of colony_bytes
+        size_t element_bytes;       // sizeof(std::pair<const K, V>), the part of a slot the user asked for
+        size_t allocator_bytes;     // what the allocator says it handed out, 0 if it doesn't say
+
+        size_t bucket_bytes() const { return hash_store_bytes + stamps_bytes + iter_store_bytes; }
+        size_t total() const { return bucket_bytes() + random_state_bytes + colony_bytes; }
+        double bytes_per_element() const { return live_slots ? total() / static_cast<double>(live_slots) : 0; }
+        // total() over the bytes of the elements themselves. 1 would be a map without any overhead
+        double overhead_ratio() const
+        {
+            return live_slots ? total() / static_cast<double>(live_slots * element_bytes) : 0;
+        }
+    };
+
+    /**
+     * @brief what the table looks like, for finding out why lookups got slow. see LP3::analyze()
+     * @details occupied means live or tombstone: lookups walk over both.
+     */
+    struct Table_analysis {
+        size_t buckets;
+        size_t live;
+        size_t tombstones;
+        // [i]: live keys a lookup finds in the (i + 1)th bucket it looks at. the last entry also counts the longer ones
+        std::vector<size_t> probe_lengths;
+        double mean_probe_length;  // of successful lookups
+        size_t max_probe_length;
+        // buckets an unsuccessful lookup looks at, averaged over all home buckets. exact for linear probing,
+        // 1 / (1 - occupied fraction) for the other policies, which jump over the clusters
+        double expected_miss_length;
+        // [k]: runs of neighbouring occupied buckets with 2^k <= length < 2^(k+1)
+        std::vector<size_t> cluster_lengths;
+        size_t largest_cluster_start;  // first bucket of the longest run, which can wrap around the end of the table
+        size_t largest_cluster_length;
+        // tombstones / buckets in equal slices of the table, front to back
+        std::vector<float> tombstone_density;
+    };
+
+    /*
+     * an allocator can report the bytes it handed out with a size_t allocated_bytes() const member.
+     * The second overload is for the ones that can't, the int/long argument picks the first one if it compiles.
+     */
+    template <class Alloc>
+    auto allocated_bytes(const Alloc& alloc, int) -> decltype(static_cast<size_t>(alloc.allocated_bytes()))
+    {
+        return alloc.allocated_bytes();
+    }
+    template <class Alloc>
+    size_t allocated_bytes(const Alloc&, long)
+    {
+        return 0;
+    }
+
+    /**
+     *  @brief  wrapper for storing hashes and a handle to the colony node
+     *  @tparam T node type stored in the colony
+     *  @tparam Allocator the colony's allocator
      *  @details
+     * LP3 keeps hashes and handles in 2 separate arrays, LP3Split still uses this.
      * This is a struct I use instead of std::pair<int, colony iterator>
      * It's just here for added semantic value, plus having a guaranteed data layout I can guarantee
      * across compilers.
      * @todo try shaving off bytes. need to go from 32 to 21 bytes/bucket to add 1 to the cache line
      *
      */
-    template <typename K, typename V>
+    template <typename T, class Allocator = std::allocator<T>>
     struct Bucket_wrapper {
-        using pair = std::pair<const K, V>;
-        using iter = naive_faster_colony_iter<K, V>;
+        using iter = naive_faster_colony_iter<T, Allocator>;
         /**
          * @param hash_ hash of the key
          * @param pair_iter_ iterator to the pair
@@ -156,10 +421,143 @@ namespace LP {
          * @param e other Bucket_wrapper
          */
         Bucket_wrapper(const Bucket_wrapper& e) : hash{e.hash}, pair_iter{e.pair_iter} {};
+        /**
+         * @brief Copy assignment, declared since the copy constructor is
+         */
+        Bucket_wrapper& operator=(const Bucket_wrapper& e) = default;
         int32_t hash;
         iter pair_iter;
     };
 
+    /**
+     * @brief 64 bits from the OS (getrandom() on linux), mixed with the clock in case random_device is a fake one
+     */
+    inline uint64_t secure_seed()
+    {
+        std::random_device device;
+        uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+        return seed ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+
+    /**
+     * @brief seeded mixer for integral keys of up to 4 bytes
+     * @details
+     * xor with the seed, then murmur3's finalizer. Both steps can be undone, so different keys keep getting
+     * different hashes, and LP3 can keep skipping the key compare on a hash match.
+     */
+    inline uint32_t mix32(uint32_t key, uint64_t seed)
+    {
+        key ^= static_cast<uint32_t>(seed);
+        key ^= key >> 16;
+        key *= 0x85ebca6bu;
+        key ^= key >> 13;
+        key *= 0xc2b2ae35u;
+        key ^= key >> 16;
+        return key;
+    }
+
+    /**
+     * @brief seeded mixer for 8 byte integral keys: murmur3's 64 bit finalizer, so the top half counts too
+     */
+    inline uint32_t mix64(uint64_t key, uint64_t seed)
+    {
+        key ^= seed;
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb93fe1a85ec3ull;
+        key ^= key >> 33;
+        return static_cast<uint32_t>(key);
+    }
+
+    /**
+     * @brief the tables of 64 bit tabulation hashing: 256 random entries for each of the 8 bytes of a hash
+     * @details 8 KiB, starting on a cache line. The entries are in [1, int32 max], so hashes are never negative
+     */
+    struct alignas(64) tabulation_table {
+        int32_t entries[8][256];
+    };
+
+    inline tabulation_table make_tabulation(uint64_t seed)
+    {
+        std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+        std::mt19937 seeded(seq);
+        std::uniform_int_distribution<int32_t> entry(1, INT32_MAX);
+        tabulation_table table;
+        for (auto& byte : table.entries) {
+            std::generate(std::begin(byte), std::end(byte), [&] { return entry(seeded); });
+        }
+        return table;
+    }
+
+    /**
+     * @brief the tables every LP3 hashes with until it reseeds
+     * @details
+     * From a fixed seed, so every process and every run hashes the same way. There's 1 copy for all maps, so a program
+     * with lots of small maps keeps 8 KiB of tables in cache instead of 8 KiB per map.
+     */
+    inline const tabulation_table& default_tabulation()
+    {
+        static const tabulation_table table = make_tabulation(INT32_MAX - 2020);
+        return table;
+    }
+
+    // default_tabulation() as the shared_ptr LP3 keeps its tables in. It owns nothing
+    inline std::shared_ptr<const tabulation_table> shared_tabulation()
+    {
+        return {std::shared_ptr<void>{}, &default_tabulation()};
+    }
+
+    /**
+     * @brief tabulation hashing over all 8 bytes of the user's hash
+     * @return a non negative hash
+     */
+    inline int32_t tabulate(uint64_t hash, const tabulation_table& table)
+    {
+        int32_t final_hash = 0;
+        for (int i = 0; i < 8; i++) {
+            final_hash ^= table.entries[i][(hash >> (8 * i)) & 0xff];
+        }
+        return final_hash;
+    }
+
+    /**
+     * @brief tabulate() for n hashes at once
+     * @details
+     * With AVX2 it does 8 hashes at a time: their low and high halves get split into 2 vectors, and every byte
+     * position is 1 gather from its table. The loads of the 8 hashes overlap instead of each hash waiting on its own
+     * chain of 8 loads. Without AVX2, and for the last n % 8 hashes, it's the scalar tabulate().
+     */
+    inline void tabulate(const uint64_t* hashes, size_t n, int32_t* out, const tabulation_table& table)
+    {
+        size_t i = 0;
+#ifdef __AVX2__
+        const __m256i halves_apart = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        const __m256i low_byte = _mm256_set1_epi32(0xff);
+        for (; i + 8 <= n; i += 8) {
+            // a = low halves of hashes 0-3, high halves of 0-3, b the same for hashes 4-7
+            const __m256i a = _mm256_permutevar8x32_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i)), halves_apart);
+            const __m256i b = _mm256_permutevar8x32_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i + 4)), halves_apart);
+            __m256i halves[2] = {_mm256_permute2x128_si256(a, b, 0x20), _mm256_permute2x128_si256(a, b, 0x31)};
+            __m256i result = _mm256_setzero_si256();
+            for (int half = 0; half < 2; half++) {
+                for (int byte = 0; byte < 4; byte++) {
+                    const __m256i index = _mm256_and_si256(halves[half], low_byte);
+                    const __m256i entries = _mm256_i32gather_epi32(table.entries[4 * half + byte], index, 4);
+                    result = _mm256_xor_si256(result, entries);
+                    halves[half] = _mm256_srli_epi32(halves[half], 8);
+                }
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = tabulate(hashes[i], table);
+        }
+    }
+
 }  // namespace LP
 
 /**
@@ -169,6 +567,8 @@ namespace LP {
  * @tparam Hash Hashing function that should be used to hash keys
  * @tparam Pred equality function to check if keys are equal
  * @tparam Allocator=std::allocator the allocator
+ * @tparam Probe=LP::linear_probe order in which buckets are probed, see the probing policies
+ * @tparam Stats=LP::no_stats instrumentation hooks, see LPstats.h. LP::counting_stats<> counts them per thread
  *
  * @details
  * A linear probing map
@@ -181,12 +581,13 @@ namespace LP {
  * It has all the good bits of deque without the downsides.
  * Using it does bring some additional downsides, however.
  * To be able to delete, I need to store an iter to it's position.
- * a Colony::iter is bigger than a pointer (32 bytes vs 16 bytes)
- * I can only fit 2 buckets in a cache line instead of the previous 4.
- * Consequently, probing is slower. But now, everything works.
- * potential solutions:
- * 1. shave off 7 bytes of the bucket
- * Do that by converting the pointers to custom length integers. Try to find a pattern in the iterator internals.
+ * a Colony::iter is bigger than a pointer (24 bytes vs 8 bytes)
+ * That's why the buckets are split in 2 parallel arrays: hash_store with only the int32 hashes, and iter_store
+ * with the iterators. Probing walks hash_store (16 hashes per cache line) and only looks in iter_store
+ * when a hash matches, instead of loading 24 bytes of iterator for every 4 bytes of hash it wants.
+ * Next to hash_store there's a byte per bucket with the generation it was written in, so clear() doesn't have to
+ * reset the buckets. Probing reads both. A stamp of 0 is never current, so all zero bytes is an empty table,
+ * and the 3 arrays come from calloc (LP::zeroed_array) without being written to.
  * LP3.merge and LP3.extract are not implemented. These rely on the assumption that I can remove the pointer
  * to the node to my container, thereby adding/removing an element without copy/move, and leaving pointers and refs
  * intact. I could do something emulating the behaviour partially. Just insert the bucket_wrapper to the other node,
@@ -202,42 +603,84 @@ namespace LP {
  *
  *
  */
-template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>,
-          class Allocator = std::allocator<std::pair<const K, V>>>
+template <typename K, typename V, typename Hash = typename LP::default_hash<K>::type,
+          typename Pred = typename LP::default_equal<K>::type, class Allocator = std::allocator<std::pair<const K, V>>,
+          class Probe = LP::linear_probe, class Stats = LP::no_stats>
 class LP3 {
-    using Bucket = LP::Bucket_wrapper<K, V>;
     using Pair_elem = std::pair<const K, V>;
-    using plf_iter = typename plf::colony<Pair_elem, Allocator>::iterator;
-    using plf_constiter = typename plf::colony<Pair_elem, Allocator>::const_iterator;
+    using Node = LP::Bucket_node<Pair_elem>;
+    using Node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using Handle = LP::naive_faster_colony_iter<Node, Node_allocator>;
+    using plf_iter = typename plf::colony<Node, Node_allocator>::iterator;
+    using plf_constiter = typename plf::colony<Node, Node_allocator>::const_iterator;
 
   private:
     Hash user_hash;
     Pred is_equal;
     int inserted_n;
-    uint64_t modulo_help;               // faster modulo trick thing, see lemire's fastmod
-    float lf_max;                       // max loadfactor
-    std::vector<Bucket> hash_store;     // stores <hash, kv_pair iterator>
-    std::vector<int32_t> random_state;  // random bits used for hashing
-    plf::colony<Pair_elem, Allocator> kv_store;
+    int deleted_n;                               // tombstones in hash_store
+    uint64_t modulo_help;                        // faster modulo trick thing, see lemire's fastmod
+    float lf_max;                                // max loadfactor
+    float lf_min = 0;                            // shrink when an erase goes below it, 0: never
+    bool in_place = false;                       // rehash inside the bucket arrays, see in_place_rehash()
+    uint8_t generation = 1;                      // see clear(), never 0
+    uint64_t int_seed = 0;                       // 0: integral keys are their own hash. see reseed()
+    size_t flood_limit = 128;                    // an insert probing further than this reseeds, 0: never
+    int reseed_at = 0;                           // inserted_n has to get here before flooding reseeds again
+    LP::zeroed_array<int32_t> hash_store;        // hashes, the only thing probing streams through
+    LP::zeroed_array<uint8_t> stamps;            // generation each bucket was last written in, 0: never
+    LP::zeroed_array<Handle> iter_store;         // kv_pair iterators, parallel to hash_store. read on a hash match
+    std::shared_ptr<const LP::tabulation_table> random_state;  // LP::default_tabulation() until reseed()
+    plf::colony<Node, Node_allocator> kv_store;  // elements, each with the index of its bucket
+    std::function<void(const LP::Resize_event&)> resize_hook;  // see on_resize()
 
     void hasher_state_gen();  // generates randomness for hashing function
-    // prober and hasher function overloads, using SFINAE to distingguish between
-    // integral types smaller equal than 4 bytes, other integral types, and non integral types
-    template <typename ShortIntegral,
-              LP::enable_if_t<std::is_integral<ShortIntegral>{} && sizeof(ShortIntegral) <= 4, bool> = true>
-    size_t prober(ShortIntegral key, const int32_t& hash) const;  // <=4bit integral types
-    template <typename LongIntegral,
-              LP::enable_if_t<(std::is_integral<LongIntegral>{} && sizeof(LongIntegral) > 4), bool> = true>
-    size_t prober(LongIntegral key, const int32_t& hash) const;  // >4bit integral types
-    template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool> = true>
-    size_t prober(const NonIntegral& key, const int32_t& hash) const;  // other types
+    // integral keys up to 4 bytes are their own hash, so a matching hash is a matching key,
+    // except for the 2 keys hasher() has to flip because they collide with EMPTY and DELETED
+    static constexpr bool hash_is_key = std::is_integral<K>{} && sizeof(K) <= 4;
+    bool keys_match(size_t pos, const K& key, const int32_t& hash) const;
+    // hash_store[pos], or EMPTY if it was written before the last clear()
+    int32_t hash_at(size_t pos) const { return stamps[pos] == generation ? hash_store[pos] : LP::EMPTY; }
+    void set_bucket(size_t pos, int32_t hash)
+    {
+        hash_store[pos] = hash;
+        stamps[pos] = generation;
+    }
+    size_t prober(const K& key, const int32_t& hash) const;  // probes following the Probe policy
+    size_t probe_count(int32_t hash, size_t pos) const;       // buckets from hash's home bucket to pos, pos included
+    void check_flooding(size_t pos, int32_t hash);            // after an insert into pos, see flood_threshold()
+    // hasher function overloads, using SFINAE to distinguish between integral and non integral types
     template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool> = true>
     int32_t hasher(Integral key) const;  // hashes key for integral type
     template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool> = true>
     int32_t hasher(const NonIntegral& key) const;  // hashes key for non integral type
 
-    void rehash(size_t size);                     // rehashes
+    void rehash(size_t size, LP::Resize_cause cause);           // rehashes
+    void rehash_in_place(size_t size, LP::Resize_cause cause);  // rehash() without a second set of bucket arrays
+    // tells on_resize() and the USDT probes, returns the timestamp it used (0 when nobody listens)
+    uint64_t trace_resize(LP::Resize_event::Phase phase, LP::Resize_cause cause, size_t old_size, size_t new_size,
+                          uint64_t started) const;
+    void rehash_if_needed();                      // grows/cleans up before an insert would overflow lf_max
+    void shrink_if_needed();                      // shrinks after an erase went below lf_min
     LP::Result contains_key(const K& key) const;  // prober() with extended info
+    // kv_store.emplace(), telling Stats when the colony needed a new group
+    template <class... Args>
+    plf_iter emplace_node(Args&&... args)
+    {
+        if (!Stats::enabled) {
+            return kv_store.emplace(std::forward<Args>(args)...);
+        }
+        const size_t capacity = kv_store.capacity();
+        auto it = kv_store.emplace(std::forward<Args>(args)...);
+        if (kv_store.capacity() != capacity) {
+            Stats::colony_allocation();
+        }
+        return it;
+    }
+    template <class Combine>
+    void merge_one(int32_t hash, Pair_elem& kv, Combine& combine);  // merge_parallel's single threaded insert
+    template <class Colony, class F>
+    static void run_chunks(Colony& colony, LP::thread_pool& pool, F f);  // f(thread, first, last) on pool
 
   public:
     // iterators
@@ -254,8 +697,8 @@ class LP3 {
 
       public:
         Iterator(plf_iter plf) : slave{plf} {};
-        reference operator*() const { return *slave; }
-        pointer operator->() { return slave.operator->(); }
+        reference operator*() const { return slave->kv; }
+        pointer operator->() { return &slave->kv; }
         // Prefix increment
         Iterator& operator++()
         {
@@ -298,8 +741,8 @@ class LP3 {
       public:
         ConstIterator(plf_constiter plf) : slave{plf} {};
         ConstIterator(Iterator lp3_it) : slave{lp3_it.slave} {};
-        reference operator*() const { return *slave; }
-        pointer operator->() { return slave.operator->(); }
+        reference operator*() const { return slave->kv; }
+        pointer operator->() { return &slave->kv; }
         // Prefix increment
         ConstIterator& operator++()
         {
@@ -437,6 +880,17 @@ class LP3 {
     Iterator erase(Iterator pos);
 #else
 #endif
+    template <class Combine>
+    void merge_parallel(std::vector<LP3>& partials, Combine combine, size_t threads = 0);
+    // parallel algorithms, every thread of pool takes a share of the elements
+    template <class F>
+    void for_each(F f, LP::thread_pool& pool);
+    template <class F>
+    void transform_values(F f, LP::thread_pool& pool);
+    template <class T, class Reduce, class Transform>
+    T reduce(T init, Reduce reduce, Transform transform, LP::thread_pool& pool) const;
+    template <class Predicate>
+    size_t erase_if(Predicate pred, LP::thread_pool& pool);
     //   modifying lookups
     V& operator[](const K& k);
     V& operator[](K&& k);
@@ -460,14 +914,32 @@ class LP3 {
     //    bucket interface
     size_t bucket_count() const { return hash_store.size(); };
     size_t max_bucket_count() const { return max_size(); };
-    size_t bucket_size(size_t n) const { return (kv_store[n].hash >= 0); };
+    size_t bucket_size(size_t n) const { return (hash_at(n) != LP::EMPTY && hash_at(n) != LP::DELETED); };
     size_t bucket(const K& key) const { return contains_key(key).pos; };
+    size_t probe_length(const K& key) const;  // buckets looked at to find key, or to find out it isn't there
+    LP::Table_analysis analyze(size_t regions = 64) const;  // probe lengths, clusters and tombstones, in 1 pass
     //    Hash policy
     float load_factor() const { return kv_store.size() / (float)hash_store.size(); };
     float max_load_factor() const { return lf_max; };
     void max_load_factor(float ml);
+    float min_load_factor() const { return lf_min; };
+    void min_load_factor(float ml);
     void rehash();
     void reserve(int size);
+    void shrink_to_fit();
+    void compact();
+    LP::Memory_usage memory_usage() const;
+    // grow (and clean up) inside the bucket arrays, for tables that don't fit in memory twice. Off by default
+    void in_place_rehash(bool on) { in_place = on; };
+    bool in_place_rehash() const { return in_place; };
+    void purge_tombstones() { rehash_in_place(hash_store.size(), LP::Resize_cause::purge_tombstones); };
+    // hash flooding defence: an insert that probes more buckets than this calls reseed(). 0 turns it off
+    void flood_threshold(size_t probes) { flood_limit = probes; };
+    size_t flood_threshold() const { return flood_limit; };
+    void reseed();
+    // hook(event) at the start and the end of every rehash, on the thread doing it. It mustn't use the map.
+    // an empty std::function turns it off
+    void on_resize(std::function<void(const LP::Resize_event&)> hook) { resize_hook = std::move(hook); };
 
     //     observers
     Hash hash_function() const { return Hash{}; };
@@ -486,8 +958,8 @@ class LP3 {
 The behavior is undefined if Key or T are not EqualityComparable.
  *
  */
-template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
-bool operator==(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_>& rhs);
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_, class Probe_, class Stats_>
+bool operator==(const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& rhs);
 
 /**
  *
@@ -501,8 +973,8 @@ bool operator==(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_,
  *  The behavior is undefined if Key or T are not EqualityComparable.
  *
  */
-template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
-bool operator!=(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_>& rhs);
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_, class Probe_, class Stats_>
+bool operator!=(const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& rhs);
 
 #if __cplusplus >= 201703L
 /**
@@ -512,8 +984,8 @@ bool operator!=(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_,
  * @details
  * swaps the maps by calling lhs.swap(rhs)
  */
-template <class Key, class T, class Hash, class KeyEqual, class Alloc>
-void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc>& rhs) noexcept;
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats>
+void swap(LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& rhs) noexcept;
 #else
 /**
  *
@@ -522,8 +994,8 @@ void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, A
  * @details
  * swaps the maps by calling lhs.swap(rhs)
  */
-template <class Key, class T, class Hash, class KeyEqual, class Alloc>
-void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc>& rhs);
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats>
+void swap(LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& rhs);
 #endif
 
 #ifndef LP3_DEF_H
@@ -538,7 +1010,7 @@ void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, A
  * @return hashed value of key
  * @details
  * function to generate hashes.
- * it's tabulation hashing.
+ * it's tabulation hashing, over all 8 bytes of the user's hash (see LP::tabulation_table).
  * It's not important to know how it works, just copy it, or
  * use something that works for your map.
  * one of the cuckoo hashing papers uses this.
@@ -549,44 +1021,52 @@ void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, A
  * i could totally ignore the user's hashing function
  */
 
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool>>
-int32_t LP3<K, V, Hash, Pred, Allocator>::hasher(const NonIntegral& key) const
+int32_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::hasher(const NonIntegral& key) const
 {
-    int32_t hash = user_hash(key);
-    int32_t final_hash = 0;
-    int32_t pos = 0;
-    for (int i = 0; i < sizeof(hash); i++) {
-        pos = hash & 0x00000000000000ff;
-        hash = hash >> 8;
-        final_hash = final_hash ^ random_state[pos + i];
-    }
-    if (final_hash < 0) {
-        final_hash = final_hash * -1;
-    }
-    return final_hash;
+    return LP::tabulate(static_cast<uint64_t>(user_hash(key)), *random_state);
 }
 
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool>>
-int32_t LP3<K, V, Hash, Pred, Allocator>::hasher(Integral key) const
+int32_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::hasher(Integral key) const
 {
-    return (key == LP::DELETED || key == LP::EMPTY) ? ~key : key;
+    int32_t hash = key;  // truncate first, so 64 bit keys can't end up as EMPTY or DELETED either
+    if (int_seed != 0) {
+        [[unlikely]] hash = sizeof(Integral) <= 4 ? LP::mix32(static_cast<uint32_t>(key), int_seed)
+                                                  : LP::mix64(static_cast<uint64_t>(key), int_seed);
+    }
+    return (hash == LP::DELETED || hash == LP::EMPTY) ? ~hash : hash;
 }
 
 /**
  * @brief
  * generate random values so hasher can use them
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::hasher_state_gen()
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::hasher_state_gen()
 {
-    std::vector<int32_t> state(259);
-    std::generate(state.begin(), state.end(), LP::gen_integer);
-    random_state = std::move(state);
+    random_state = LP::shared_tabulation();
     user_hash = Hash();
 }
 
+/**
+ * @param pos bucket whose hash equals hash
+ * @return whether the key in bucket pos is key
+ * @details
+ * for integral types up to 4 bytes, the hash is the key, so the key itself is only looked at
+ * when the hash was one of the 2 flipped ones. hash_is_key is constexpr, the check folds away for other types.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+inline bool LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::keys_match(size_t pos, const K& key, const int32_t& hash) const
+{
+    if (hash_is_key && hash != ~LP::DELETED && hash != ~LP::EMPTY) {
+        return true;
+    }
+    return is_equal(iter_store[pos]->kv.first, key);
+}
+
 /**
  *
  * @param key The key whose position should be determined
@@ -598,88 +1078,245 @@ void LP3<K, V, Hash, Pred, Allocator>::hasher_state_gen()
  * 1. hash = empty
  * 2. same key.
  * it returns the position where the element is, or should be inserted.
- * uses SFINAE overloads for generi K type, short integral type, and long integral type
+ * The order in which buckets are visited comes from the Probe policy. Only hash_store is read
+ * until a hash matches.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool>>
-size_t LP3<K, V, Hash, Pred, Allocator>::prober(const NonIntegral& key, const int32_t& hash) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+size_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::prober(const K& key, const int32_t& hash) const
 {
-    int32_t size = hash_store.size();
-    size_t pos = fastmod::fastmod_s32(hash, modulo_help, size);
-    for (int i = 0; i < size; i++) {
-        if (hash_store[pos].hash != LP::EMPTY
-            && (hash_store[pos].hash != hash || not is_equal(hash_store[pos].pair_iter->first, key))) {
-            pos++;
-            if (pos >= size) {
-                pos -= size;
-            }
-        }
-        else {
+    const size_t size = hash_store.size();
+    size_t pos = LP::home_slot(hash, modulo_help, size);
+    LP::prefetch(&iter_store[pos]);  // on a hit, the iterator is most likely in the home position's line
+    const size_t step = Probe::step(hash, size);
+    for (size_t i = 0; i < size; i++) {
+        const int32_t bucket_hash = hash_at(pos);
+        if (bucket_hash == LP::EMPTY || (bucket_hash == hash && keys_match(pos, key, hash))) {
+            Stats::lookup(i + 1);
             return pos;
         }
+        if (Stats::enabled && bucket_hash == hash) {  // same hash, other key
+            Stats::key_mismatch();
+        }
+        pos = Probe::next(pos, i, step, size);
     }
-    return pos;
-}
-
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-// template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool>>
-template <typename ShortIntegral,
-          LP::enable_if_t<std::is_integral<ShortIntegral>{} && sizeof(ShortIntegral) <= 4, bool>>
-size_t LP3<K, V, Hash, Pred, Allocator>::prober(ShortIntegral key, const int32_t& hash) const
-{
-    int32_t size = hash_store.size();
-    int32_t pos = fastmod::fastmod_s32(hash, modulo_help, size);
-    pos = (pos < 0) ? ~pos : pos;
-    // hash = ~key if hash = deleted or empty, meaning that ~DEL or ~EMPTY hashes have a collision chance
-    if (hash == ~LP::DELETED || hash == ~LP::EMPTY) { [[unlikely]]
-        for (int i = 0; i < size; i++) {
-            if (hash_store[pos].hash != LP::EMPTY
-                && (hash_store[pos].hash != hash || hash_store[pos].pair_iter->first != key)) {
-                pos++;
-                if (pos >= size) {
-                    pos -= size;
-                }
-            }
-            else {
-                return pos;
-            }
+    Stats::lookup(size);
+    return pos;  // only when there's no empty bucket left
+}
+
+/**
+ * @param key
+ * @return the number of buckets a lookup of key examines, including the one it stops at
+ * @details
+ * same walk as prober(). 1 means the key is in its home bucket, or the home bucket is empty.
+ * Meant for measuring clustering, not for the hot path.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+size_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::probe_length(const K& key) const
+{
+    const int32_t hash = hasher(key);
+    const size_t size = hash_store.size();
+    size_t pos = LP::home_slot(hash, modulo_help, size);
+    const size_t step = Probe::step(hash, size);
+    for (size_t i = 0; i < size; i++) {
+        const int32_t bucket_hash = hash_at(pos);
+        if (bucket_hash == LP::EMPTY || (bucket_hash == hash && keys_match(pos, key, hash))) {
+            return i + 1;
         }
+        pos = Probe::next(pos, i, step, size);
     }
-    // most cases
-    for (int i = 0; i < size; i++) {
-        if (hash_store[pos].hash != LP::EMPTY && hash_store[pos].hash != hash) {
-            pos++;
-            if (pos >= size) {
-                pos -= size;
+    return size;
+}
+
+/**
+ * @details
+ * Doesn't read the table: linear probing is a subtraction, the other policies replay their sequence until it
+ * gets to pos, which costs as many steps as the answer.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+size_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::probe_count(int32_t hash, size_t pos) const
+{
+    const size_t size = hash_store.size();
+    const size_t home = LP::home_slot(hash, modulo_help, size);
+    if (std::is_same<Probe, LP::linear_probe>{}) {
+        return 1 + ((pos >= home) ? pos - home : pos + size - home);
+    }
+    size_t probes = 1;
+    const size_t step = Probe::step(hash, size);
+    for (size_t i = 0, at = home; at != pos && i < size; i++, probes++) {
+        at = Probe::next(at, i, step, size);
+    }
+    return probes;
+}
+
+/**
+ * @details
+ * Random keys practically never probe that far, keys that do are picked to collide, or the hash function is bad.
+ * A reseed costs O(n), so it waits until the map has doubled since the last one: under an attack that keeps going,
+ * inserts stay amortized O(1) instead of rehashing the table over and over.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+inline void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::check_flooding(size_t pos, int32_t hash)
+{
+    if (flood_limit == 0 || inserted_n < reseed_at) {
+        return;
+    }
+    if (probe_count(hash, pos) > flood_limit) {
+        [[unlikely]] reseed();
+    }
+}
+
+/**
+ * @brief new hash state from a seed nobody can guess, and every element rehashed with it
+ * @details
+ * Keys that were picked to collide under the old state (which is the same in every process, see
+ * LP::default_tabulation()) are spread out again. Integral keys stop being their own hash and go through a seeded
+ * mixer. Keys whose user hash itself collides stay together: that's up to the Hash.
+ * The hashes get recomputed from the keys, then an in place rehash moves them, so it needs no second table.
+ * Iterators and references stay valid.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::reseed()
+{
+    const uint64_t seed = LP::secure_seed();
+    random_state = std::make_shared<const LP::tabulation_table>(LP::make_tabulation(seed));
+    int_seed = seed | 1;  // never 0, that's the unseeded identity hash
+    if (std::is_integral<K>{}) {
+        for (size_t pos = 0; pos < hash_store.size(); pos++) {
+            const int32_t hash = hash_at(pos);
+            if (hash != LP::EMPTY && hash != LP::DELETED) {
+                hash_store[pos] = hasher(iter_store[pos]->kv.first);
             }
         }
-        else {
-            return pos;
+    }
+    else {
+        // the user's hashes in batches, for the vectorized LP::tabulate()
+        constexpr size_t batch = 64;
+        size_t spots[batch];
+        uint64_t user_hashes[batch];
+        int32_t hashes[batch];
+        size_t n = 0;
+        auto flush = [&] {
+            LP::tabulate(user_hashes, n, hashes, *random_state);
+            for (size_t i = 0; i < n; i++) {
+                hash_store[spots[i]] = hashes[i];
+            }
+            n = 0;
+        };
+        for (size_t pos = 0; pos < hash_store.size(); pos++) {
+            const int32_t hash = hash_at(pos);
+            if (hash != LP::EMPTY && hash != LP::DELETED) {
+                spots[n] = pos;
+                user_hashes[n++] = static_cast<uint64_t>(user_hash(iter_store[pos]->kv.first));
+                if (n == batch) {
+                    flush();
+                }
+            }
         }
+        flush();
     }
-    return pos;  // will never hit, just removing compiler warning
+    rehash_in_place(hash_store.size(), LP::Resize_cause::reseed);
+    reseed_at = 2 * inserted_n;
 }
 
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-template <typename LongIntegral, LP::enable_if_t<(std::is_integral<LongIntegral>{} && sizeof(LongIntegral) > 4), bool>>
-size_t LP3<K, V, Hash, Pred, Allocator>::prober(LongIntegral key, const int32_t& hash) const
+/**
+ * @brief statistics about the whole table: probe lengths, clusters and tombstones
+ * @param regions number of slices tombstone_density splits the table into
+ * @details
+ * 1 front to back pass over the hashes and stamps. It never touches the handles or the elements, the probe length
+ * of a live key follows from its hash and its bucket. So a health check can call it on a big table without
+ * pulling the elements into cache.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP::Table_analysis LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::analyze(size_t regions) const
 {
-    int32_t size = hash_store.size();
-    int32_t pos = fastmod::fastmod_s32(hash, modulo_help, size);
-    pos = (pos < 0) ? ~pos : pos;
-    for (int i = 0; i < size; i++) {
-        if (hash_store[pos].hash != LP::EMPTY
-            && (hash_store[pos].hash != hash || hash_store[pos].pair_iter->first != key)) {
-            pos++;
-            if (pos >= size) {
-                pos -= size;
+    const size_t size = hash_store.size();
+    regions = std::max<size_t>(1, std::min(regions, size));
+    LP::Table_analysis result{};
+    result.buckets = size;
+    result.probe_lengths.assign(32, 0);
+    result.cluster_lengths.assign(1, 0);
+    result.tombstone_density.assign(regions, 0);
+
+    size_t probe_sum = 0;
+    double miss_sum = 0;
+    // a run that starts at bucket 0 can be the end of one that wraps around, so it's only counted at the end
+    bool leading_done = false;
+    size_t leading = 0;
+    size_t run = 0;
+    size_t run_start = 0;
+    auto add_run = [&](size_t length, size_t start) {
+        if (length == 0) {
+            return;
+        }
+        size_t k = 0;
+        while ((size_t{2} << k) <= length) {
+            k++;
+        }
+        if (k >= result.cluster_lengths.size()) {
+            result.cluster_lengths.resize(k + 1, 0);
+        }
+        result.cluster_lengths[k]++;
+        // a miss that starts at the ith bucket of the run looks at the rest of it and the empty bucket after it
+        miss_sum += length * (length + 1.0) / 2 + length;
+        if (length > result.largest_cluster_length) {
+            result.largest_cluster_length = length;
+            result.largest_cluster_start = start;
+        }
+    };
+
+    for (size_t pos = 0; pos < size; pos++) {
+        const int32_t hash = hash_at(pos);
+        if (hash == LP::EMPTY) {
+            if (leading_done) {
+                add_run(run, run_start);
             }
+            else {
+                leading = run;
+                leading_done = true;
+            }
+            run = 0;
+            miss_sum += 1;
+            continue;
+        }
+        if (run++ == 0) {
+            run_start = pos;
+        }
+        if (hash == LP::DELETED) {
+            result.tombstones++;
+            result.tombstone_density[pos * regions / size]++;
+            continue;
+        }
+        result.live++;
+        const size_t probes = probe_count(hash, pos);
+        probe_sum += probes;
+        result.max_probe_length = std::max(result.max_probe_length, probes);
+        result.probe_lengths[std::min(probes, result.probe_lengths.size()) - 1]++;
+    }
+    if (leading_done) {
+        add_run(leading + run, run ? run_start : 0);
+    }
+    else {  // no empty bucket at all, a miss walks the whole table
+        add_run(size, 0);
+        miss_sum = static_cast<double>(size) * size;
+    }
+
+    if (size != 0) {
+        if (std::is_same<Probe, LP::linear_probe>{}) {
+            result.expected_miss_length = miss_sum / size;
         }
         else {
-            return pos;
+            const double empty_share = 1 - (result.live + result.tombstones) / static_cast<double>(size);
+            result.expected_miss_length = empty_share > 0 ? 1 / empty_share : static_cast<double>(size);
+        }
+        for (size_t r = 0; r < regions; r++) {
+            // region r holds the buckets [ceil(r * size / regions), ceil((r + 1) * size / regions))
+            const size_t first = (r * size + regions - 1) / regions;
+            const size_t last = ((r + 1) * size + regions - 1) / regions;
+            result.tombstone_density[r] /= static_cast<float>(last - first);
         }
     }
-    return pos;
+    result.mean_probe_length = result.live ? probe_sum / static_cast<double>(result.live) : 0;
+    return result;
 }
 
 /**
@@ -689,26 +1326,52 @@ size_t LP3<K, V, Hash, Pred, Allocator>::prober(LongIntegral key, const int32_t&
  * @details
  * probe bucket arr, and if the resulting position is empty, key doesn't exist
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP::Result LP3<K, V, Hash, Pred, Allocator>::contains_key(const K& key) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP::Result LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::contains_key(const K& key) const
 {
     int32_t hash = hasher(key);
     int pos = prober(key, hash);
 
-    if (hash_store[pos].hash == LP::EMPTY) {
+    if (hash_at(pos) == LP::EMPTY) {
         return {false, pos, hash};
     }
     return {true, pos, hash};
 }
 
-// // Removing 2 lines of code I have to write in every insert function
-// template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-// void LP3<K, V, Hash, Pred, Allocator>::rehash_if_needed()
-//{
-//    if (((inserted_n + 1) / (float)hash_store.size()) > lf_max) {
-//        rehash();
-//    }
-//}
+/**
+ * @brief Removing 2 lines of code I have to write in every insert function
+ * @details
+ * Tombstones count towards the load here. They're never reused by inserts, and a table that's full of them
+ * has no empty buckets left to stop a probe. rehash() sizes the new table for the live elements only,
+ * so a table that's mostly tombstones gets cleaned up at the same size instead of growing.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+inline void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::rehash_if_needed()
+{
+    if (((inserted_n + deleted_n + 1) / (float)hash_store.size()) > lf_max) {
+        // room for the element being inserted too, or a full table gets rehashed to the size it has
+        [[unlikely]] rehash(LP::next_prime(int((kv_store.size() + 1) / lf_max)), LP::Resize_cause::insert);
+    }
+}
+
+/**
+ * @details
+ * Shrinks to a load of half lf_max, so it takes a lot of inserts to grow again, and unused colony groups get freed.
+ * min_load_factor() keeps lf_min under half of lf_max, so a shrink always lands above it.
+ * Only the bucket arrays change, so iterators stay valid and erase_if can keep going.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+inline void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::shrink_if_needed()
+{
+    if (inserted_n >= lf_min * hash_store.size()) {
+        [[likely]] return;
+    }
+    size_t size = LP::next_prime(1 + inserted_n / (lf_max / 2));
+    if (size < hash_store.size()) {
+        rehash(size, LP::Resize_cause::erase);
+        kv_store.trim();
+    }
+}
 //--------------------------- END PRIVATE FUNCTIONS
 
 /**
@@ -722,8 +1385,8 @@ LP::Result LP3<K, V, Hash, Pred, Allocator>::contains_key(const K& key) const
  * default constructor that delegates to constructor with explicit size.
  * reason why i'm not doing only LP3(size=something) is compiler complaints
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3() : LP3{LP3<K, V>(251)}
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3() : LP3(size_t(251))
 {
 }
 
@@ -741,13 +1404,16 @@ LP3<K, V, Hash, Pred, Allocator>::LP3() : LP3{LP3<K, V>(251)}
  * > LP3<int, int> map{}
  * > map.reserve(1024)
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(size_t size, const Hash& hash, const Pred& equal, const Allocator& alloc)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(size_t size, const Hash& hash, const Pred& equal, const Allocator& alloc)
     : is_equal(Pred()),
       inserted_n{0},
+      deleted_n{0},
       modulo_help(fastmod::computeM_s32(LP::next_prime(2 * size))),
       lf_max{0.5},
-      hash_store{std::vector<Bucket>(LP::next_prime(2 * size))},
+      hash_store(LP::next_prime(2 * size)),
+      stamps(LP::next_prime(2 * size)),
+      iter_store(LP::next_prime(2 * size)),
       kv_store{}
 {
     hasher_state_gen();
@@ -758,8 +1424,8 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(size_t size, const Hash& hash, const Pred&
  * @param bucket_count the bucket count
  * @param alloc the allocator
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(size_t bucket_count, const Allocator& alloc) : LP3{bucket_count}
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(size_t bucket_count, const Allocator& alloc) : LP3{bucket_count}
 {
 }
 /**
@@ -768,8 +1434,8 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(size_t bucket_count, const Allocator& allo
  * @param hash hash function
  * @param alloc allocator
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(size_t size, const Hash& hash, const Allocator& alloc) : LP3{size}
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(size_t size, const Hash& hash, const Allocator& alloc) : LP3{size}
 {
     user_hash = hash;
 }
@@ -780,8 +1446,8 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(size_t size, const Hash& hash, const Alloc
  * @param hash hash function
  * @param alloc allocator
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(const Allocator& alloc) : LP3{}
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(const Allocator& alloc) : LP3{}
 {
 }
 
@@ -793,9 +1459,9 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(const Allocator& alloc) : LP3{}
  * Constraint: `std::is_constructible<std::pair<const K,V>, typename
  * std::iterator_traits<InputIt>::value_type>::value` is true
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class InputIt>
-LP3<K, V, Hash, Pred, Allocator>::LP3(InputIt first, InputIt last) : LP3{LP3<K, V>(std::distance(first, last))}
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(InputIt first, InputIt last) : LP3(size_t(std::distance(first, last)))
 {
     static_assert(std::is_constructible<Pair_elem, typename std::iterator_traits<InputIt>::value_type>{},
                   "Iterator's value_type must be able to construct a pair<const K, V>");
@@ -810,10 +1476,10 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(InputIt first, InputIt last) : LP3{LP3<K,
  * @param last iterator to last element of the range you want to include
  * @param size size suggestion. May be ignored.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class InputIt>
-LP3<K, V, Hash, Pred, Allocator>::LP3(InputIt first, InputIt last, size_t size)
-    : LP3{LP3<K, V>(std::max((size_t)std::distance(first, last), (size_t)size))}
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(InputIt first, InputIt last, size_t size)
+    : LP3(std::max((size_t)std::distance(first, last), (size_t)size))
 {
     static_assert(std::is_constructible<Pair_elem, typename std::iterator_traits<InputIt>::value_type>{},
                   "Iterator's value_type must be able to construct a pair<const K, V>");
@@ -826,19 +1492,29 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(InputIt first, InputIt last, size_t size)
  * @details Copy constructor
  * @param other Other LP3 you want to copy
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(const LP3& other)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(const LP3& other)
     : is_equal(other.is_equal),
       inserted_n{other.inserted_n},
+      deleted_n{other.deleted_n},
       modulo_help(other.modulo_help),
       lf_max{other.lf_max},
-      hash_store{other.hash_store.size()},
+      lf_min{other.lf_min},
+      in_place{other.in_place},
+      generation{other.generation},
+      int_seed{other.int_seed},
+      flood_limit{other.flood_limit},
+      reseed_at{other.reseed_at},
+      hash_store(other.hash_store),
+      stamps(other.stamps),
+      iter_store(other.iter_store.size()),
       random_state{other.random_state},
-      kv_store{other.kv_store}
+      kv_store{other.kv_store},
+      resize_hook{other.resize_hook}
 {
+    // same size and hash state, so every element goes in the bucket it had, and the nodes know which one that is
     for (auto it = kv_store.begin(); it != kv_store.end(); it++) {
-        auto pos_info = contains_key(it->first);
-        hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
+        iter_store[it->bucket] = it;
     }
 };
 
@@ -846,8 +1522,8 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(const LP3& other)
  * @details Move constructor
  * @param other Other hashmap you want to move
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(LP3&& other)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(LP3&& other)
 {
     other.swap(*this);
     other.clear();
@@ -857,8 +1533,8 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(LP3&& other)
  * @brief constructor from initializer list
  * @param init initializer_list
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(std::initializer_list<Pair_elem> init) : LP3{LP3<K, V>{init.size()}}
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(std::initializer_list<Pair_elem> init) : LP3(init.size())
 {
     for (const auto& x : init) {
         insert(x);
@@ -869,9 +1545,9 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(std::initializer_list<Pair_elem> init) : L
  * @param init initializer_list
  * @param bucket_count bucket count. It may be ignored
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>::LP3(std::initializer_list<Pair_elem> init, size_t bucket_count)
-    : LP3{LP3<K, V>(std::max(bucket_count, init.size()))}
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::LP3(std::initializer_list<Pair_elem> init, size_t bucket_count)
+    : LP3(std::max(bucket_count, init.size()))
 {
     for (const auto& x : init) {
         insert(x);
@@ -886,15 +1562,11 @@ LP3<K, V, Hash, Pred, Allocator>::LP3(std::initializer_list<Pair_elem> init, siz
  * @param other map you want to copy assign
  * @return this with the new state
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(const LP3& other)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::operator=(const LP3& other)
 {
     auto temp{other};
     std::swap(*this, temp);
-    for (auto it = kv_store.begin(); it != kv_store.end(); it++) {
-        auto pos_info = contains_key(it->first);
-        hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
-    }
     return *this;
 }
 
@@ -904,8 +1576,8 @@ LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(co
  * @param other map you want to move assign
  * @return this with the new state
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(LP3&& other) noexcept
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::operator=(LP3&& other) noexcept
 {
     swap(other);
     return *this;
@@ -915,8 +1587,8 @@ LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(LP
  * @param other map you want to move assign
  * @return this with the new state
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(LP3&& other)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::operator=(LP3&& other)
 {
     //    using namespace std;
     swap(other);
@@ -928,8 +1600,8 @@ LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(LP
  * @param ilist initializer list
  * @return
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(std::initializer_list<Pair_elem> ilist)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::operator=(std::initializer_list<Pair_elem> ilist)
 {
     auto temp = LP3{ilist};
     temp.swap(*this);
@@ -940,14 +1612,22 @@ LP3<K, V, Hash, Pred, Allocator>& LP3<K, V, Hash, Pred, Allocator>::operator=(st
 // ------------------- begin modifying functions
 
 /**
- * @brief deletes all keys and values, so size is 0. Beware that _capacity_ is still that of the original
+ * @brief deletes all keys and values, so size is 0. The bucket count stays what it was
+ * @details
+ * The buckets aren't touched: every bucket remembers the generation it was written in, and clear() starts a new one,
+ * so buckets from before read as EMPTY. Only the elements get destroyed, the table costs O(1) to clear.
+ * Once every 255 clears the generation wraps, and the stamps get zeroed so old buckets can't come back.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::clear() noexcept
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::clear() noexcept
 {
     kv_store.clear();
-    hash_store.clear();
+    if (++generation == 0) {
+        stamps.zero();
+        generation = 1;
+    }
     inserted_n = 0;
+    deleted_n = 0;
 }
 
 // ------------------- begin insert overloads
@@ -958,20 +1638,20 @@ void LP3<K, V, Hash, Pred, Allocator>::clear() noexcept
  * @details
  * inserts element, returns pair<iterator to map[k], bool is inserted>
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator>::insert(
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(
     const LP3::Pair_elem& kv)
 {
-    if (((inserted_n + 1) / (float)hash_store.size()) > lf_max) {
-        [[unlikely]] rehash();
-    }
+    rehash_if_needed();
     auto pos_info = contains_key(kv.first);
     if (pos_info.contains) {
-        [[unlikely]] return {hash_store[pos_info.pos].pair_iter.convert(), false};
+        [[unlikely]] return {iter_store[pos_info.pos].convert(), false};
     }
-    auto it = kv_store.insert(kv);
-    hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
+    auto it = emplace_node(pos_info.pos, kv);
+    set_bucket(pos_info.pos, pos_info.hash);
+    iter_store[pos_info.pos] = it;
     inserted_n++;
+    check_flooding(pos_info.pos, pos_info.hash);
     return std::pair<Iterator, bool>(it, true);
 }
 
@@ -983,20 +1663,20 @@ std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, H
  * @details
  * inserts element, returns pair<iterator to map[k], bool is inserted>
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator>::insert(
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(
     LP3::Pair_elem&& kv)
 {
-    if (((inserted_n + 1) / (float)hash_store.size()) > lf_max) {
-        [[unlikely]] rehash();
-    }
+    rehash_if_needed();
     auto pos_info = contains_key(kv.first);
     if (pos_info.contains) {
-        [[unlikely]] return {hash_store[pos_info.pos].pair_iter.convert(), false};
+        [[unlikely]] return {iter_store[pos_info.pos].convert(), false};
     }
-    auto it = kv_store.insert(std::forward<Pair_elem>(kv));
-    hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
+    auto it = emplace_node(pos_info.pos, std::forward<Pair_elem>(kv));
+    set_bucket(pos_info.pos, pos_info.hash);
+    iter_store[pos_info.pos] = it;
     inserted_n++;
+    check_flooding(pos_info.pos, pos_info.hash);
     return std::pair<Iterator, bool>(it, true);
 }
 
@@ -1007,20 +1687,20 @@ std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, H
  * @details
  * inserts element, returns iterator to map[k]
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::insert(ConstIterator hint,
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(ConstIterator hint,
                                                                                              const Pair_elem&& kv)
 {
-    if (((inserted_n + 1) / (float)hash_store.size()) > lf_max) {
-        rehash();
-    }
+    rehash_if_needed();
     auto pos_info = contains_key(kv.first);
     if (pos_info.contains) {
-        return hash_store[pos_info.pos].pair_iter.convert();
+        return iter_store[pos_info.pos].convert();
     }
-    auto it = kv_store.insert(std::move(kv));
-    hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
+    auto it = emplace_node(pos_info.pos, std::move(kv));
+    set_bucket(pos_info.pos, pos_info.hash);
+    iter_store[pos_info.pos] = it;
     inserted_n++;
+    check_flooding(pos_info.pos, pos_info.hash);
     return it;
 }
 
@@ -1033,8 +1713,8 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @details
  * inserts element, returns iterator to map[k]
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::insert(ConstIterator hint,
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(ConstIterator hint,
                                                                                              const Pair_elem& kv)
 {
     return insert(kv).first;
@@ -1047,11 +1727,11 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @param value element to insert
  * @return pair<iterator, bool is inserted>
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <typename P,
           LP::enable_if_t<
               (std::is_constructible<std::pair<const K, V>, P>{} && !std::is_same<P, std::pair<const K, V>>{}), bool>>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator>::insert(P&& value)
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(P&& value)
 {
     return insert(Pair_elem{value});
 }
@@ -1063,24 +1743,24 @@ std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, H
  * @param value element to insert
  * @return iterator to inserted or existing element
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <typename P,
           LP::enable_if_t<
               (std::is_constructible<std::pair<const K, V>, P>{} && !std::is_same<P, std::pair<const K, V>>{}), bool>>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::insert(ConstIterator hint,
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(ConstIterator hint,
                                                                                              P&& value)
 {
-    if (((inserted_n + 1) / (float)hash_store.size()) > lf_max) {
-        rehash();
-    }
+    rehash_if_needed();
     Pair_elem kv{value};
     auto pos_info = contains_key(kv.first);
     if (pos_info.contains) {
-        return hash_store[pos_info.pos].pair_iter.convert();
+        return iter_store[pos_info.pos].convert();
     }
-    auto it = kv_store.insert(std::move(kv));
-    hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
+    auto it = emplace_node(pos_info.pos, std::move(kv));
+    set_bucket(pos_info.pos, pos_info.hash);
+    iter_store[pos_info.pos] = it;
     inserted_n++;
+    check_flooding(pos_info.pos, pos_info.hash);
     return it;
 }
 /**
@@ -1090,9 +1770,9 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @param first iterator to first element of the iter range that needs to be inserted
  * @param last iterator to last element of the iter range that needs to be inserted
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class InputIt>
-void LP3<K, V, Hash, Pred, Allocator>::insert(InputIt first, InputIt last)
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(InputIt first, InputIt last)
 {
     while (first != last) {
         insert(*first++);
@@ -1102,8 +1782,8 @@ void LP3<K, V, Hash, Pred, Allocator>::insert(InputIt first, InputIt last)
 /**
  * @param ilist initilizer list of kv pairs
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::insert(std::initializer_list<Pair_elem> ilist)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert(std::initializer_list<Pair_elem> ilist)
 {
     for (auto x : ilist) {
         insert(std::move(x));
@@ -1129,21 +1809,24 @@ void LP3<K, V, Hash, Pred, Allocator>::insert(std::initializer_list<Pair_elem> i
  inserts the new value as if by insert,
  constructing it from value_type(k, std::forward<M>(obj))
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class M>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator>::insert_or_assign(
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert_or_assign(
     const K& k, M&& obj)
 {
+    rehash_if_needed();
     auto pos_info = contains_key(k);
     if (pos_info.contains) {
-        auto it = hash_store[pos_info.pos].pair_iter;
-        it->second = std::forward<M>(obj);
+        auto it = iter_store[pos_info.pos];
+        it->kv.second = std::forward<M>(obj);
         return {it.convert(), false};
     }
     else {
-        auto it = kv_store.insert({k, std::forward<M>(obj)});
-        hash_store[pos_info.pos] = {pos_info.hash, it};
+        auto it = emplace_node(pos_info.pos, k, std::forward<M>(obj));
+        set_bucket(pos_info.pos, pos_info.hash);
+        iter_store[pos_info.pos] = it;
         inserted_n++;
+        check_flooding(pos_info.pos, pos_info.hash);
         return std::pair<Iterator, bool>(it, true);
     }
 }
@@ -1154,21 +1837,24 @@ std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, H
  * assigns std::forward<M>(obj) to pair.second if assigned
  * @return <iterator to modified location, bool is_inserted>
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class M>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator>::insert_or_assign(
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert_or_assign(
     K&& k, M&& obj)
 {
+    rehash_if_needed();
     auto pos_info = contains_key(k);
     if (pos_info.contains) {
-        auto it = hash_store[pos_info.pos].pair_iter;
-        it->second = std::forward<M>(obj);
+        auto it = iter_store[pos_info.pos];
+        it->kv.second = std::forward<M>(obj);
         return {it.convert(), false};
     }
     else {
-        auto it = kv_store.insert({std::forward<K>(k), std::forward<M>(obj)});
-        hash_store[pos_info.pos] = {pos_info.hash, it};
+        auto it = emplace_node(pos_info.pos, std::forward<K>(k), std::forward<M>(obj));
+        set_bucket(pos_info.pos, pos_info.hash);
+        iter_store[pos_info.pos] = it;
         inserted_n++;
+        check_flooding(pos_info.pos, pos_info.hash);
         return {it, true};
     }
 }
@@ -1182,9 +1868,9 @@ std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, H
  constructing it from value_type(k, std::forward<M>(obj))
  * @return iterator to modified location
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class M>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::insert_or_assign(
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert_or_assign(
     ConstIterator hint, const K& k, M&& obj)
 {
     return insert_or_assign(k, std::forward<M>(obj)).first;
@@ -1197,9 +1883,9 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * assigns std::forward<M>(obj) to pair.second if assigned
  * @return iterator to modified location
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class M>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::insert_or_assign(
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::insert_or_assign(
     ConstIterator hint, K&& k, M&& obj)
 {
     return insert_or_assign(std::forward<K>(k), std::forward<M>(obj)).first;
@@ -1218,9 +1904,9 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @return  pair(iter to inserted, bool inserted)
  *
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class... Args>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator>::emplace(
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, bool> LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::emplace(
     Args&&... args)
 {
     //    TODO: remove the guaranteed instantiation, use
@@ -1237,9 +1923,9 @@ std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3<K, V, H
  * @param args
  * @return
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
 template <class... Args>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::emplace_hint(ConstIterator hint,
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::emplace_hint(ConstIterator hint,
                                                                                                    Args&&... args)
 {
     //    TODO: remove the guaranteed instantiation, use
@@ -1254,34 +1940,54 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @details swap 2 hashmaps with each other
  */
 #    if __cplusplus >= 201703L
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::swap(LP3& other) noexcept
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::swap(LP3& other) noexcept
 {
     std::swap(user_hash, other.user_hash);
     std::swap(is_equal, other.is_equal);
     std::swap(inserted_n, other.inserted_n);
+    std::swap(deleted_n, other.deleted_n);
     std::swap(modulo_help, other.modulo_help);
     std::swap(lf_max, other.lf_max);
+    std::swap(lf_min, other.lf_min);
+    std::swap(in_place, other.in_place);
+    std::swap(generation, other.generation);
+    std::swap(int_seed, other.int_seed);
+    std::swap(flood_limit, other.flood_limit);
+    std::swap(reseed_at, other.reseed_at);
     std::swap(hash_store, other.hash_store);
+    std::swap(stamps, other.stamps);
+    std::swap(iter_store, other.iter_store);
     std::swap(random_state, other.random_state);
     std::swap(kv_store, other.kv_store);
+    std::swap(resize_hook, other.resize_hook);
     return;
 }
 #    else
 /**
  * @brief swaps LP3 instances
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::swap(LP3& other)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::swap(LP3& other)
 {
     std::swap(user_hash, other.user_hash);
     std::swap(is_equal, other.is_equal);
     std::swap(inserted_n, other.inserted_n);
+    std::swap(deleted_n, other.deleted_n);
     std::swap(modulo_help, other.modulo_help);
     std::swap(lf_max, other.lf_max);
+    std::swap(lf_min, other.lf_min);
+    std::swap(in_place, other.in_place);
+    std::swap(generation, other.generation);
+    std::swap(int_seed, other.int_seed);
+    std::swap(flood_limit, other.flood_limit);
+    std::swap(reseed_at, other.reseed_at);
     std::swap(hash_store, other.hash_store);
+    std::swap(stamps, other.stamps);
+    std::swap(iter_store, other.iter_store);
     std::swap(random_state, other.random_state);
     std::swap(kv_store, other.kv_store);
+    std::swap(resize_hook, other.resize_hook);
     return;
 }
 #    endif
@@ -1289,17 +1995,20 @@ void LP3<K, V, Hash, Pred, Allocator>::swap(LP3& other)
 /**
  * @brief erase elements..
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-size_t LP3<K, V, Hash, Pred, Allocator>::erase(const K& key)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+size_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::erase(const K& key)
 {
     auto pos_info = contains_key(key);
     if (not pos_info.contains) {
         return 0;
     }
     auto pos = pos_info.pos;
-    hash_store[pos].hash = LP::DELETED;
-    kv_store.erase(hash_store[pos].pair_iter.convert());
+    set_bucket(pos, LP::DELETED);
+    Stats::tombstone_created();
+    kv_store.erase(iter_store[pos].convert());
     inserted_n--;
+    deleted_n++;
+    shrink_if_needed();
     return 1;
 }
 
@@ -1308,27 +2017,29 @@ size_t LP3<K, V, Hash, Pred, Allocator>::erase(const K& key)
  * @return it++
  * @details
  * if it == LP3.cend(), returns cend()
+ * The node knows its bucket, so the key doesn't get hashed or probed for.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::erase(ConstIterator it)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::erase(ConstIterator it)
 {
     if (it == kv_store.cend()) {
         return Iterator{it.slave};
     }
-    auto pos_info = contains_key(it->first);
-    auto pos = pos_info.pos;
-    hash_store[pos].hash = LP::DELETED;
-    kv_store.erase(it.slave);
+    set_bucket(it.slave->bucket, LP::DELETED);
+    Stats::tombstone_created();
     inserted_n--;
-    return Iterator{++it.slave};
+    deleted_n++;
+    Iterator next{kv_store.erase(it.slave)};
+    shrink_if_needed();
+    return next;
 }
 
 /**
  * @param first, last range of elements to delete
  * @return last++
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::erase(ConstIterator first,
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::erase(ConstIterator first,
                                                                                             ConstIterator last)
 {
     while (first != last) {
@@ -1344,14 +2055,306 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @details
  * if it == LP3.cend(), returns cend()
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::erase(Iterator it)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::erase(Iterator it)
 {
     return erase(ConstIterator{it});
 }
 #    else
 #    endif
 
+/**
+ * @brief inserts kv with a known hash, or combines it with the value that's already there
+ * @details no rehash, merge_parallel sized the table beforehand
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class Combine>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::merge_one(int32_t hash, Pair_elem& kv, Combine& combine)
+{
+    size_t pos = prober(kv.first, hash);
+    if (hash_at(pos) != LP::EMPTY) {
+        combine(iter_store[pos]->kv.second, std::move(kv.second));
+        return;
+    }
+    auto it = emplace_node(pos, kv.first, std::move(kv.second));
+    set_bucket(pos, hash);
+    iter_store[pos] = it;
+}
+
+/**
+ * @brief moves the elements of partials into this map, using threads threads
+ * @param partials maps to merge, values are moved out of them and they're empty afterwards
+ * @param combine void(V& into, V&& from), for keys that are in more than 1 map (or already in this one).
+ * Keys meet in the order of partials, after what this map already had. It shouldn't throw.
+ * @param threads 0 means std::thread::hardware_concurrency()
+ * @details
+ * Meant for group-by: every thread fills its own LP3 without any contention, and this puts them together.
+ * The table gets sized for all elements first, so nothing rehashes halfway. Then:
+ * 1. every thread takes a slice of the buckets of every partial, and sorts the elements it finds by which
+ *    thread owns their home bucket in this map. Thread r owns the home buckets [r * size / threads, (r+1) * size / threads).
+ * 2. every thread inserts the elements of its own range into its own colony. Linear probing from a home bucket
+ *    in a range only reads and writes buckets of that range, as long as it doesn't walk past its end.
+ *    Equal keys have equal home buckets, so a key's copies all meet in the same thread.
+ * 3. the colonies get spliced into kv_store, which moves their memory blocks, not the elements.
+ *    The few elements whose probe walked past the end of their range get inserted afterwards, on 1 thread.
+ * Stored hashes are reused when the partial hashes keys the same way as this map: always for integral keys,
+ * and for other keys when the partials are copies of 1 map (copies share the tabulation state). An empty map
+ * takes the state of the first partial.
+ * Other probe policies don't stay inside a range, so with those it all happens on 1 thread.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class Combine>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::merge_parallel(std::vector<LP3>& partials, Combine combine,
+                                                             size_t threads)
+{
+    using Spot = std::pair<int32_t, Pair_elem*>;  // hash, element in a partial
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // what's already here is merged like a partial that comes first
+    const size_t old_size = hash_store.size();
+    std::vector<LP3*> sources;
+    LP3 previous(size_t(0));
+    if (!empty()) {
+        // only the elements and their buckets move, the settings and the hook stay with this map
+        std::swap(kv_store, previous.kv_store);
+        std::swap(hash_store, previous.hash_store);
+        std::swap(stamps, previous.stamps);
+        std::swap(iter_store, previous.iter_store);
+        std::swap(generation, previous.generation);
+        std::swap(inserted_n, previous.inserted_n);
+        std::swap(deleted_n, previous.deleted_n);
+        previous.random_state = random_state;
+        previous.int_seed = int_seed;
+        sources.push_back(&previous);
+    }
+    else if (!partials.empty()) {
+        random_state = partials.front().random_state;
+        int_seed = partials.front().int_seed;
+    }
+    size_t total = previous.size();
+    for (auto& partial : partials) {
+        sources.push_back(&partial);
+        total += partial.size();
+    }
+    const size_t size = std::max(old_size, LP::next_prime(1 + total / lf_max));
+    hash_store = LP::zeroed_array<int32_t>(size);
+    stamps = LP::zeroed_array<uint8_t>(size);
+    iter_store = LP::zeroed_array<Handle>(size);
+    modulo_help = fastmod::computeM_s32(size);
+    deleted_n = 0;
+
+    if (!std::is_same<Probe, LP::linear_probe>::value || threads == 1) {
+        for (LP3* source : sources) {
+            for (auto& node : source->kv_store) {
+                merge_one(hasher(node.kv.first), node.kv, combine);
+            }
+        }
+    }
+    else {
+        const size_t source_n = sources.size();
+        std::vector<char> same_hashes(source_n);
+        for (size_t s = 0; s < source_n; s++) {
+            same_hashes[s] = std::is_integral<K>{} ? sources[s]->int_seed == int_seed
+                                                   : sources[s]->random_state == random_state;
+        }
+        // parts[(source * threads + slicer) * threads + owner], so every owner sees the partials in order
+        std::vector<std::vector<Spot>> parts(source_n * threads * threads);
+        std::vector<plf::colony<Node, Node_allocator>> colonies(threads);
+        std::vector<std::vector<Spot>> spills(threads);
+        auto range_begin = [&](size_t r) { return (r * size + threads - 1) / threads; };
+
+        auto slice = [&](size_t u) {
+            for (size_t s = 0; s < source_n; s++) {
+                const LP3& source = *sources[s];
+                const size_t n = source.hash_store.size();
+                for (size_t slot = n * u / threads; slot < n * (u + 1) / threads; slot++) {
+                    int32_t hash = source.hash_at(slot);
+                    if (hash == LP::EMPTY || hash == LP::DELETED) {
+                        continue;
+                    }
+                    Pair_elem* kv = &source.iter_store[slot]->kv;
+                    if (!same_hashes[s]) {
+                        hash = hasher(kv->first);
+                    }
+                    size_t owner = LP::home_slot(hash, modulo_help, size) * threads / size;
+                    parts[(s * threads + u) * threads + owner].emplace_back(hash, kv);
+                }
+            }
+        };
+        auto merge_range = [&](size_t r) {
+            const size_t end = range_begin(r + 1);
+            for (size_t part = r; part < parts.size(); part += threads) {
+                for (const Spot& spot : parts[part]) {
+                    size_t pos = LP::home_slot(spot.first, modulo_help, size);
+                    for (; pos < end; pos++) {
+                        if (hash_at(pos) == LP::EMPTY) {
+                            auto it = colonies[r].emplace(pos, spot.second->first, std::move(spot.second->second));
+                            set_bucket(pos, spot.first);
+                            iter_store[pos] = it;
+                            break;
+                        }
+                        if (hash_at(pos) == spot.first && keys_match(pos, spot.second->first, spot.first)) {
+                            combine(iter_store[pos]->kv.second, std::move(spot.second->second));
+                            break;
+                        }
+                    }
+                    if (pos == end) {
+                        spills[r].push_back(spot);
+                    }
+                }
+            }
+        };
+        auto run = [&](auto step) {
+            std::vector<std::thread> workers;
+            for (size_t t = 1; t < threads; t++) {
+                workers.emplace_back(step, t);
+            }
+            step(0);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        };
+        run(slice);
+        run(merge_range);
+        for (auto& colony : colonies) {
+            kv_store.splice(colony);
+        }
+        for (auto& spilled : spills) {
+            for (const Spot& spot : spilled) {
+                merge_one(spot.first, *spot.second, combine);
+            }
+        }
+    }
+    inserted_n = kv_store.size();
+    for (auto& partial : partials) {
+        partial.clear();
+    }
+}
+
+/**
+ * @brief splits colony into pool.size() runs of about equal length and calls f(thread, first, last) for each
+ * @details
+ * colony's advance skips whole groups, so finding the split points costs about 1 step per group, and every thread
+ * walks its own stretch of memory front to back. An empty colony doesn't call f at all.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class Colony, class F>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::run_chunks(Colony& colony, LP::thread_pool& pool, F f)
+{
+    using It = decltype(colony.begin());
+    const size_t n = colony.size();
+    if (n == 0) {
+        return;
+    }
+    const size_t threads = std::min(pool.size(), n);
+    std::vector<It> bounds{colony.begin()};
+    for (size_t t = 1; t < threads; t++) {
+        bounds.push_back(std::next(bounds.back(), n * t / threads - n * (t - 1) / threads));
+    }
+    bounds.push_back(colony.end());
+    pool.run([&](size_t t) {
+        if (t < threads) {
+            f(t, bounds[t], bounds[t + 1]);
+        }
+    });
+}
+
+/**
+ * @brief calls f(std::pair<const K, V>&) for every element, on all threads of pool
+ * @details f runs concurrently, so it may change the value it gets but nothing else in the map
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class F>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::for_each(F f, LP::thread_pool& pool)
+{
+    run_chunks(kv_store, pool, [&](size_t, plf_iter first, plf_iter last) {
+        for (; first != last; ++first) {
+            f(first->kv);
+        }
+    });
+}
+
+/**
+ * @brief replaces every value with f(const K&, const V&), on all threads of pool
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class F>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::transform_values(F f, LP::thread_pool& pool)
+{
+    for_each([&](Pair_elem& kv) { kv.second = f(static_cast<const K&>(kv.first), static_cast<const V&>(kv.second)); },
+             pool);
+}
+
+/**
+ * @brief folds transform(element) of every element into init with reduce, on all threads of pool
+ * @param reduce T(T, T), has to be associative and commutative, the elements come in no particular order
+ * @param transform T(const std::pair<const K, V>&)
+ * @details every thread folds its own share starting at its first element, then those get folded into init
+ * in thread order. No identity element needed.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class T, class Reduce, class Transform>
+T LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::reduce(T init, Reduce reduce, Transform transform,
+                                                  LP::thread_pool& pool) const
+{
+    std::vector<std::vector<T>> partial(pool.size());  // empty or 1 element, T needn't be default constructible
+    run_chunks(kv_store, pool, [&](size_t t, plf_constiter first, plf_constiter last) {
+        T folded = transform(first->kv);
+        for (++first; first != last; ++first) {
+            folded = reduce(std::move(folded), transform(first->kv));
+        }
+        partial[t].push_back(std::move(folded));
+    });
+    for (auto& folded : partial) {
+        for (auto& value : folded) {
+            init = reduce(std::move(init), std::move(value));
+        }
+    }
+    return init;
+}
+
+/**
+ * @brief erases every element pred(const std::pair<const K, V>&) is true for, using all threads of pool
+ * @return number of erased elements
+ * @details
+ * Every thread takes a slice of the buckets, calls pred on their elements and turns the buckets of the ones that
+ * go into tombstones right there, so nothing gets probed for. Erasing the elements from the colony happens
+ * afterwards on the calling thread, it isn't thread safe.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+template <class Predicate>
+size_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::erase_if(Predicate pred, LP::thread_pool& pool)
+{
+    const size_t threads = pool.size();
+    const size_t n = hash_store.size();
+    std::vector<std::vector<plf_iter>> doomed(threads);
+    pool.run([&](size_t t) {
+        for (size_t pos = n * t / threads; pos < n * (t + 1) / threads; pos++) {
+            if (hash_at(pos) == LP::EMPTY || hash_at(pos) == LP::DELETED) {
+                continue;
+            }
+            if (pred(static_cast<const Pair_elem&>(iter_store[pos]->kv))) {
+                set_bucket(pos, LP::DELETED);
+                Stats::tombstone_created();
+                doomed[t].push_back(iter_store[pos].convert());
+            }
+        }
+    });
+    size_t erased = 0;
+    for (auto& iters : doomed) {
+        for (auto& it : iters) {
+            kv_store.erase(it);
+        }
+        erased += iters.size();
+    }
+    inserted_n -= erased;
+    deleted_n += erased;
+    shrink_if_needed();
+    return erased;
+}
+
 // -------------- begin lookups
 
 /**
@@ -1363,18 +2366,21 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * if there is, return value
  * if there isn't, insert V{} and return reff. to that.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-V& LP3<K, V, Hash, Pred, Allocator>::operator[](const K& k)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+V& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::operator[](const K& k)
 {
+    rehash_if_needed();
     auto pos_info = contains_key(k);
     if (pos_info.contains) {
-        [[likely]] return hash_store[pos_info.pos].pair_iter->second;
+        [[likely]] return iter_store[pos_info.pos]->kv.second;
     }
-    auto it = kv_store.insert(Pair_elem{k, V{}});
     auto pos = pos_info.pos;
-    hash_store[pos] = {pos_info.hash, it};
+    auto it = emplace_node(pos, k, V{});
+    set_bucket(pos, pos_info.hash);
+    iter_store[pos] = it;
     inserted_n++;
-    return it->second;
+    check_flooding(pos, pos_info.hash);
+    return it->kv.second;
 }
 
 /**
@@ -1386,18 +2392,21 @@ V& LP3<K, V, Hash, Pred, Allocator>::operator[](const K& k)
  * if there is, return value
  * if there isn't, insert V{} and return reff. to that.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-V& LP3<K, V, Hash, Pred, Allocator>::operator[](K&& k)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+V& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::operator[](K&& k)
 {
+    rehash_if_needed();
     auto pos_info = contains_key(k);
     if (pos_info.contains) {
-        [[likely]] return hash_store[pos_info.pos].pair_iter->second;
+        [[likely]] return iter_store[pos_info.pos]->kv.second;
     }
-    auto it = kv_store.insert(Pair_elem{k, V{}});  // change back to forward later
     auto pos = pos_info.pos;
-    hash_store[pos] = {pos_info.hash, it};
+    auto it = emplace_node(pos, k, V{});  // change back to forward later
+    set_bucket(pos, pos_info.hash);
+    iter_store[pos] = it;
     inserted_n++;
-    return it->second;
+    check_flooding(pos, pos_info.hash);
+    return it->kv.second;
 }
 // --------------------- end modifying functions
 /**
@@ -1407,12 +2416,12 @@ V& LP3<K, V, Hash, Pred, Allocator>::operator[](K&& k)
  * @details Returns a reference to the mapped value of the element with key equivalent to key.
  * If no such element exists, an exception of type std::out_of_range is thrown.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-V& LP3<K, V, Hash, Pred, Allocator>::at(const K& k)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+V& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::at(const K& k)
 {
     auto pos_info = contains_key(k);
     if (pos_info.contains) {
-        [[likely]] return hash_store[pos_info.pos].pair_iter->second;
+        [[likely]] return iter_store[pos_info.pos]->kv.second;
     }
     else {
         throw std::out_of_range("key doesn't exist");
@@ -1426,12 +2435,12 @@ V& LP3<K, V, Hash, Pred, Allocator>::at(const K& k)
  * @details Returns a reference to the mapped value of the element with key equivalent to key.
  * If no such element exists, an exception of type std::out_of_range is thrown.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-const V& LP3<K, V, Hash, Pred, Allocator>::at(const K& k) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+const V& LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::at(const K& k) const
 {
     auto pos_info = contains_key(k);
     if (pos_info.contains) {
-        [[likely]] return hash_store[pos_info.pos].pair_iter->second;
+        [[likely]] return iter_store[pos_info.pos]->kv.second;
     }
     else {
         throw std::out_of_range("key doesn't exist");
@@ -1442,8 +2451,8 @@ const V& LP3<K, V, Hash, Pred, Allocator>::at(const K& k) const
  * @details returns 1 if key exists, 0 otherwise
  * @return 1 if key exists, 0 otherwise
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-size_t LP3<K, V, Hash, Pred, Allocator>::count(const K& key) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+size_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::count(const K& key) const
 {
     return contains_key(key).contains;
 }
@@ -1451,12 +2460,12 @@ size_t LP3<K, V, Hash, Pred, Allocator>::count(const K& key) const
  * @param key key to find
  * @return iterator to key if exists, LP3.end() if it doesn't
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Allocator>::find(const K& key)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::find(const K& key)
 {
     auto pos_info = contains_key(key);
     if (pos_info.contains) {
-        return hash_store[pos_info.pos].pair_iter.convert();
+        return iter_store[pos_info.pos].convert();
     }
     return kv_store.end();
 }
@@ -1465,12 +2474,12 @@ typename LP3<K, V, Hash, Pred, Allocator>::Iterator LP3<K, V, Hash, Pred, Alloca
  * @param key key to find
  * @return iterator to key if exists, LP3.end() if it doesn't
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-typename LP3<K, V, Hash, Pred, Allocator>::ConstIterator LP3<K, V, Hash, Pred, Allocator>::find(const K& key) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::ConstIterator LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::find(const K& key) const
 {
     auto pos_info = contains_key(key);
     if (pos_info.contains) {
-        Iterator it = hash_store[pos_info.pos].pair_iter.convert();
+        Iterator it = iter_store[pos_info.pos].convert();
         return {it};
     }
     return kv_store.cend();
@@ -1486,13 +2495,13 @@ typename LP3<K, V, Hash, Pred, Allocator>::ConstIterator LP3<K, V, Hash, Pred, A
  * atm, i haven't changed it, because i haven't checked if there's any perf advantage
  * in leaving it like this, eliminating 1 call to a function.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-bool LP3<K, V, Hash, Pred, Allocator>::contains(const K& key) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+bool LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::contains(const K& key) const
 {
     int32_t hash = hasher(key);
     int pos = prober(key, hash);
 
-    if (hash_store[pos].hash == LP::EMPTY) {
+    if (hash_at(pos) == LP::EMPTY) {
         return false;
     }
     return true;
@@ -1506,9 +2515,9 @@ bool LP3<K, V, Hash, Pred, Allocator>::contains(const K& key) const
  * @return std::pair containing a pair of iterators defining the wanted range. If there are no such elements,
  * past-the-end iterators are returned as both elements of the pair.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::Iterator, typename LP3<K, V, Hash, Pred, Allocator>::Iterator>
-LP3<K, V, Hash, Pred, Allocator>::equal_range(const K& key)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator, typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::Iterator>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::equal_range(const K& key)
 {
     Iterator first = find(key);
     if (first == end()) {
@@ -1523,10 +2532,10 @@ LP3<K, V, Hash, Pred, Allocator>::equal_range(const K& key)
  * @return std::pair containing a pair of const iterators defining the wanted range. If there are no such elements,
  * past-the-end iterators are returned as both elements of the pair.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-std::pair<typename LP3<K, V, Hash, Pred, Allocator>::ConstIterator,
-          typename LP3<K, V, Hash, Pred, Allocator>::ConstIterator>
-LP3<K, V, Hash, Pred, Allocator>::equal_range(const K& key) const
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+std::pair<typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::ConstIterator,
+          typename LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::ConstIterator>
+LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::equal_range(const K& key) const
 {
     ConstIterator first = find(key);
     if (first == cend()) {
@@ -1537,24 +2546,44 @@ LP3<K, V, Hash, Pred, Allocator>::equal_range(const K& key) const
 /**
  *
  * @param ml new max loadfactor
- * @throws std::out_of_range if ml > 1
+ * @throws std::out_of_range if ml > Probe::max_load
  * @details
  * Manages the maximum load factor (number of elements per bucket).
  * The container automatically increases the number of buckets if the load factor exceeds this threshold.
- *
+ * The probe policy caps it: quadratic probing only reaches every bucket up to a load of 0.5.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::max_load_factor(float ml)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::max_load_factor(float ml)
 {
-    if (ml > 1) {
-        throw std::out_of_range("max loadfactor is 1");
+    if (ml > Probe::max_load) {
+        throw std::out_of_range("max loadfactor is too high for this probe policy");
+    }
+    if (ml <= 2 * lf_min) {
+        throw std::out_of_range("max loadfactor has to stay over twice the min loadfactor");
     }
     lf_max = ml;
     if (kv_store.size() / (float)hash_store.size() > ml) {
-        rehash(inserted_n / ml);
+        rehash(LP::next_prime(int(inserted_n / ml)), LP::Resize_cause::max_load_factor);
     }
 }
 
+/**
+ * @param ml new min loadfactor, 0 turns shrinking off (the default)
+ * @throws std::out_of_range if ml isn't below half the max loadfactor
+ * @details
+ * An erase that takes the load below ml shrinks the table to a load of max_load_factor() / 2, and frees
+ * the colony's empty groups. The gap between the 2 is the hysteresis: a map that hovers around 1 size
+ * doesn't keep shrinking and growing.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::min_load_factor(float ml)
+{
+    if (ml < 0 || ml >= lf_max / 2) {
+        throw std::out_of_range("min loadfactor has to be in [0, max loadfactor / 2)");
+    }
+    lf_min = ml;
+}
+
 /// ------------------ end lookups
 /**
  * @brief increase the capacity such that it can contain at least size elements and rehash
@@ -1566,36 +2595,159 @@ void LP3<K, V, Hash, Pred, Allocator>::max_load_factor(float ml)
  * @bug it actually doesn't respect loadfactor_max, so it will definitely rehash if you try to insert n=size
  * elements
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::rehash(size_t size)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::rehash(size_t size, LP::Resize_cause cause)
 {
-    std::vector<Bucket> arr_new(size);
+    if (in_place) {
+        rehash_in_place(size, cause);
+        return;
+    }
+    const LP::stats_timer<Stats> timer;
+    const size_t old_size = hash_store.size();
+    const uint64_t started = trace_resize(LP::Resize_event::Phase::start, cause, old_size, size, 0);
+    LP::zeroed_array<int32_t> hashes_new(size);
+    LP::zeroed_array<Handle> iters_new(size);
+    LP::zeroed_array<uint8_t> stamps_new(size);
     uint64_t helper = fastmod::computeM_s32(size);
-    for (const auto& x : hash_store) {
-        if (x.hash == LP::EMPTY || x.hash == LP::DELETED) {
+    for (size_t i = 0; i < hash_store.size(); i++) {
+        int32_t hash = hash_at(i);
+        if (hash == LP::EMPTY || hash == LP::DELETED) {
             continue;
         }
-        int32_t loc = fastmod::fastmod_s32(x.hash, helper, size);
-        loc = (loc < 0) ? ~loc : loc;
-        while (arr_new[loc].hash != LP::EMPTY) {
-            loc++;
-            if (loc >= size) {
-                loc -= size;
+        size_t loc = LP::home_slot(hash, helper, size);
+        size_t step = Probe::step(hash, size);
+        for (size_t probe_i = 0; stamps_new[loc] != 0; probe_i++) {
+            loc = Probe::next(loc, probe_i, step, size);
+        }
+        hashes_new[loc] = hash;
+        stamps_new[loc] = generation;
+        iters_new[loc] = iter_store[i];
+        iter_store[i]->bucket = loc;
+    }
+    hash_store = std::move(hashes_new);
+    iter_store = std::move(iters_new);
+    stamps = std::move(stamps_new);
+    modulo_help = helper;
+    Stats::rehash(timer.nanoseconds(), deleted_n);
+    deleted_n = 0;
+    trace_resize(LP::Resize_event::Phase::end, cause, old_size, size, started);
+}
+
+/**
+ * @brief rehash(size), moving the buckets around inside the arrays they're in
+ * @details
+ * For tables too big to have 2 of. The arrays get resized with realloc (before when growing, after when
+ * shrinking), so the memory on top of the table is the difference between the 2 sizes.
+ * 1. every bucket with an element gets stamped pending, everything else empty. Tombstones are gone after this.
+ * 2. every pending element goes to the first bucket of its new probe sequence that isn't placed yet.
+ *    If that's where it is, it stays. If that's empty, it moves there. If there's another pending element,
+ *    they swap, and the other one gets its turn right away.
+ * The buckets in front of a placed element's bucket are all placed, and placed elements don't move again,
+ * so a lookup walks the same buckets it would have in a table built from scratch. Works for every Probe.
+ * Slower than rehash(): the swaps jump around the table instead of writing it front to back.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::rehash_in_place(size_t size, LP::Resize_cause cause)
+{
+    const LP::stats_timer<Stats> timer;
+    const size_t old_size = hash_store.size();
+    const uint64_t started = trace_resize(LP::Resize_event::Phase::start, cause, old_size, size, 0);
+    const uint8_t pending = generation == 1 ? 2 : 1;
+    if (size > old_size) {
+        hash_store.resize(size, false);  // only read once their stamp says they were written
+        iter_store.resize(size, false);
+        stamps.resize(size);
+    }
+    for (size_t i = 0; i < old_size; i++) {
+        const int32_t hash = hash_at(i);
+        stamps[i] = (hash == LP::EMPTY || hash == LP::DELETED) ? 0 : pending;
+    }
+    const uint64_t helper = fastmod::computeM_s32(size);
+    for (size_t i = 0; i < old_size; i++) {
+        while (stamps[i] == pending) {
+            const int32_t hash = hash_store[i];
+            size_t loc = LP::home_slot(hash, helper, size);
+            const size_t step = Probe::step(hash, size);
+            for (size_t probe_i = 0; stamps[loc] == generation; probe_i++) {
+                loc = Probe::next(loc, probe_i, step, size);
+            }
+            if (loc == i) {
+                stamps[i] = generation;
+                iter_store[i]->bucket = i;
+                break;
             }
+            if (stamps[loc] == 0) {
+                hash_store[loc] = hash;
+                iter_store[loc] = iter_store[i];
+                stamps[i] = 0;
+            }
+            else {
+                std::swap(hash_store[loc], hash_store[i]);
+                std::swap(iter_store[loc], iter_store[i]);
+            }
+            stamps[loc] = generation;
+            iter_store[loc]->bucket = loc;
         }
-        arr_new[loc] = x;
     }
-    hash_store = std::move(arr_new);
+    if (size < old_size) {
+        hash_store.resize(size);
+        iter_store.resize(size);
+        stamps.resize(size);
+    }
     modulo_help = helper;
+    Stats::rehash(timer.nanoseconds(), deleted_n);
+    deleted_n = 0;
+    trace_resize(LP::Resize_event::Phase::end, cause, old_size, size, started);
+}
+
+/**
+ * @details
+ * Without a hook and without LP3_USDT it doesn't even read the clock, a rehash costs 2 checks more.
+ * The hook gets called after the USDT probe, so a hook that throws doesn't hide the event from a tracer.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+uint64_t LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::trace_resize(LP::Resize_event::Phase phase,
+                                                                     LP::Resize_cause cause, size_t old_size,
+                                                                     size_t new_size, uint64_t started) const
+{
+#ifndef LP3_USDT
+    if (!resize_hook) {
+        [[likely]] return 0;
+    }
+#endif
+    LP::Resize_event event{};
+    event.timestamp = LP::trace_clock();
+    event.nanoseconds = phase == LP::Resize_event::Phase::end ? event.timestamp - started : 0;
+    event.old_buckets = old_size;
+    event.new_buckets = new_size;
+    event.live = inserted_n;
+    event.tombstones = deleted_n;
+    event.phase = phase;
+    event.cause = cause;
+    event.in_place = in_place;
+#ifdef LP3_USDT
+    if (phase == LP::Resize_event::Phase::start) {
+        DTRACE_PROBE5(lp3, resize_start, event.old_buckets, event.new_buckets, event.live, event.tombstones,
+                      static_cast<int>(cause));
+    }
+    else {
+        DTRACE_PROBE5(lp3, resize_end, event.old_buckets, event.new_buckets, event.live, event.nanoseconds,
+                      static_cast<int>(cause));
+    }
+#endif
+    if (resize_hook) {
+        resize_hook(event);
+    }
+    return event.timestamp;
 }
 /**
  * @brief increase size and rehash. need to add this to the public interface of LP3 later.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::rehash()
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::rehash()
 {
     int size = LP::next_prime(int(kv_store.size() / lf_max));
-    rehash(size);
+    rehash(size, LP::Resize_cause::rehash);
 }
 
 /**
@@ -1603,14 +2755,101 @@ void LP3<K, V, Hash, Pred, Allocator>::rehash()
  * this is mean you'll be able to insert <size> elements into the map
  * without rehashes.
  */
-template <typename K, typename V, typename Hash, typename Pred, class Allocator>
-void LP3<K, V, Hash, Pred, Allocator>::reserve(int size)
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::reserve(int size)
 {
     int s = 1 + (size / lf_max);
     if (s < hash_store.size()) {
         return;
     }
-    rehash(s);
+    rehash(LP::next_prime(s), LP::Resize_cause::reserve);
+}
+
+/**
+ * @brief the smallest table that holds the elements without going over max_load_factor(), and a packed colony
+ * @details
+ * Packing copies the elements into full colony groups, which invalidates iterators, references and pointers.
+ * The bucket handles get fixed up through the nodes, without hashing anything.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::shrink_to_fit()
+{
+    rehash(LP::next_prime(1 + inserted_n / lf_max), LP::Resize_cause::shrink_to_fit);
+    if (kv_store.size() != kv_store.capacity()) {
+        kv_store.shrink_to_fit();
+        for (auto it = kv_store.begin(); it != kv_store.end(); it++) {
+            iter_store[it->bucket] = it;
+        }
+    }
+}
+
+/**
+ * @brief moves the elements into full colony groups, in bucket order
+ * @details
+ * After a lot of erasing, the colony is full of holes that iterating has to skip, and elements that are next to
+ * each other in the table are all over memory. This copies them into a new colony in the order of hash_store,
+ * so walking a probe sequence walks memory front to back, and fixes the handles up in the same pass.
+ * Keys are copied (they're const), values moved. Invalidates iterators, references and pointers.
+ * Meant for maintenance windows, it's O(buckets) and needs memory for a second copy of the elements.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+void LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::compact()
+{
+    plf::colony<Node, Node_allocator> packed;
+    packed.reserve(kv_store.size());
+    for (size_t pos = 0; pos < hash_store.size(); pos++) {
+        const int32_t hash = hash_at(pos);
+        if (hash == LP::EMPTY || hash == LP::DELETED) {
+            continue;
+        }
+        Pair_elem& kv = iter_store[pos]->kv;
+        auto it = packed.emplace(pos, kv.first, std::move(kv.second));
+        iter_store[pos] = it;
+    }
+    kv_store = std::move(packed);
+}
+
+/**
+ * @brief how many bytes the map uses, split up by what they're for
+ * @details
+ * Walks the colony's groups, so it's O(groups), not O(elements). The bucket arrays come from calloc, not from
+ * Allocator, so allocator_bytes only covers the colony, and only when Allocator has allocated_bytes().
+ * Memory the elements point to (the characters of a long std::string) isn't counted.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator, class Probe, class Stats>
+LP::Memory_usage LP3<K, V, Hash, Pred, Allocator, Probe, Stats>::memory_usage() const
+{
+    const auto groups = kv_store.group_stats();
+    LP::Memory_usage usage{};
+    usage.hash_store_bytes = hash_store.size() * sizeof(int32_t);
+    usage.stamps_bytes = stamps.size() * sizeof(uint8_t);
+    usage.iter_store_bytes = iter_store.size() * sizeof(Handle);
+    usage.random_state_bytes = random_state.use_count() ? sizeof(LP::tabulation_table) : 0;
+    usage.colony_bytes = groups.bytes;
+    usage.colony_groups = groups.groups;
+    usage.reserved_groups = groups.reserved_groups;
+    usage.colony_capacity = groups.capacity;
+    usage.live_slots = kv_store.size();
+    usage.erased_slots = groups.erased;
+    usage.skipfield_bytes = groups.skipfield_bytes;
+    usage.element_bytes = sizeof(Pair_elem);
+    usage.allocator_bytes = LP::allocated_bytes(kv_store.get_allocator(), 0);
+    return usage;
+}
+
+/**
+ * @param partials maps to merge, empty afterwards
+ * @param combine void(V& into, V&& from) for keys in more than 1 partial
+ * @return a new map with everything in partials
+ * @details see LP3::merge_parallel
+ */
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats, class Combine>
+LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats> merge_parallel(std::vector<LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>>& partials,
+                                                         Combine combine, size_t threads = 0)
+{
+    LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats> merged(size_t(0));
+    merged.merge_parallel(partials, combine, threads);
+    return merged;
 }
 
 /**
@@ -1618,8 +2857,8 @@ void LP3<K, V, Hash, Pred, Allocator>::reserve(int size)
  * @param pred  predicate that returns true if the element should be erased
  * @return The number of erased elements.
  */
-template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Pred>
-size_t erase_if(LP3<Key, T, Hash, KeyEqual, Alloc>& c, Pred pred)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats, class Pred>
+size_t erase_if(LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& c, Pred pred)
 {
     auto old_size = c.size();
     for (auto i = c.begin(), last = c.end(); i != last;) {
@@ -1633,6 +2872,18 @@ size_t erase_if(LP3<Key, T, Hash, KeyEqual, Alloc>& c, Pred pred)
     return old_size - c.size();
 }
 
+/**
+ * @param c container
+ * @param pred predicate that returns true if the element should be erased, called concurrently
+ * @param pool threads to use, see LP3::erase_if
+ * @return The number of erased elements.
+ */
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats, class Pred>
+size_t erase_if(LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& c, Pred pred, LP::thread_pool& pool)
+{
+    return c.erase_if(pred, pool);
+}
+
 /**
  *
  * @param lhs left lp3 map
@@ -1645,8 +2896,8 @@ size_t erase_if(LP3<Key, T, Hash, KeyEqual, Alloc>& c, Pred pred)
 The behavior is undefined if Key or T are not EqualityComparable.
  *
  */
-template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
-bool operator==(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_, class Probe_, class Stats_>
+bool operator==(const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& rhs)
 {
     if (&lhs == &rhs) {
         return true;
@@ -1677,8 +2928,8 @@ bool operator==(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_,
  *  The behavior is undefined if Key or T are not EqualityComparable.
  *
  */
-template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
-bool operator!=(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_, class Probe_, class Stats_>
+bool operator!=(const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& lhs, const LP3<K_, V_, Hash_, Pred_, Allocator_, Probe_, Stats_>& rhs)
 {
     return not(lhs == rhs);
 }
@@ -1691,8 +2942,8 @@ bool operator!=(const LP3<K_, V_, Hash_, Pred_, Allocator_>& lhs, const LP3<K_,
  * @details
  * swaps the maps by calling lhs.swap(rhs)
  */
-template <class Key, class T, class Hash, class KeyEqual, class Alloc>
-void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc>& rhs) noexcept
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats>
+void swap(LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& rhs) noexcept
 {
     lhs.swap(rhs);
 }
@@ -1704,8 +2955,8 @@ void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, A
  * @details
  * swaps the maps by calling lhs.swap(rhs)
  */
-template <class Key, class T, class Hash, class KeyEqual, class Alloc>
-void swap(LP3<Key, T, Hash, KeyEqual, Alloc>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc>& rhs)
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Probe, class Stats>
+void swap(LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& lhs, LP3<Key, T, Hash, KeyEqual, Alloc, Probe, Stats>& rhs)
 {
     lhs.swap(rhs);
 }
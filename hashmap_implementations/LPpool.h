@@ -0,0 +1,128 @@
+#ifndef LPPOOL_H
+#define LPPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LP {
+
+    /*
+     * a fixed set of threads for LP3's parallel algorithms (for_each, transform_values, reduce, erase_if).
+     *
+     * Starting threads costs more than walking a small map, so a job that runs every hour (or every second)
+     * should keep 1 pool around and hand it to every call. run(f) calls f(0) .. f(size() - 1) at the same time,
+     * f(0) on the calling thread, and returns when all of them are done.
+     * Jobs from several threads run one after the other. A job can't start another job on the same pool.
+     */
+    class thread_pool {
+        std::vector<std::thread> workers;  // size() - 1 of them, the caller is thread 0
+        std::mutex job_lock;               // 1 job at a time
+        std::mutex state_lock;
+        std::condition_variable job_ready;
+        std::condition_variable job_done;
+        std::function<void(size_t)> job;
+        size_t generation = 0;  // bumped for every job, so workers can tell a new job from the one they did
+        size_t running = 0;     // workers still busy with the current job
+        bool stopping = false;
+        std::exception_ptr error;  // first exception of the current job
+
+        void work(size_t index)
+        {
+            size_t seen = 0;
+            while (true) {
+                std::unique_lock<std::mutex> lock(state_lock);
+                job_ready.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                lock.unlock();
+                try {
+                    job(index);
+                }
+                catch (...) {
+                    lock.lock();
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    lock.unlock();
+                }
+                lock.lock();
+                if (--running == 0) {
+                    job_done.notify_one();
+                }
+            }
+        }
+
+      public:
+        /**
+         * @param threads 0 means std::thread::hardware_concurrency()
+         */
+        explicit thread_pool(size_t threads = 0)
+        {
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            for (size_t t = 1; t < threads; t++) {
+                workers.emplace_back(&thread_pool::work, this, t);
+            }
+        }
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(state_lock);
+                stopping = true;
+            }
+            job_ready.notify_all();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        size_t size() const { return workers.size() + 1; }
+
+        /**
+         * @brief calls f(t) for every t in [0, size()), each on its own thread, and waits for all of them
+         * @details rethrows the first exception any of them threw, after all of them are done
+         */
+        template <class F>
+        void run(F f)
+        {
+            std::lock_guard<std::mutex> one_job(job_lock);
+            {
+                std::lock_guard<std::mutex> lock(state_lock);
+                job = std::ref(f);
+                error = nullptr;
+                running = workers.size();
+                generation++;
+            }
+            job_ready.notify_all();
+            std::exception_ptr own_error;
+            try {
+                f(0);
+            }
+            catch (...) {
+                own_error = std::current_exception();
+            }
+            std::unique_lock<std::mutex> lock(state_lock);
+            job_done.wait(lock, [&] { return running == 0; });
+            job = nullptr;
+            if (own_error) {
+                std::rethrow_exception(own_error);
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+}  // namespace LP
+
+#endif  // LPPOOL_H
@@ -0,0 +1,379 @@
+#ifndef LPRCU_H
+#define LPRCU_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "LPmap3.h"
+
+namespace LP {
+
+    /*
+     * epoch based reclamation, shared by every LP3Rcu in the process.
+     *
+     * A reading thread writes the global epoch into its own slot before it looks at a published map, and 0 when
+     * it's done. A writer that unpublishes a map bumps the global epoch and remembers the epoch the map was
+     * unpublished in. Readers that entered later can't have seen it, so the map can be freed as soon as no slot
+     * holds an epoch up to and including that one.
+     *
+     * Readers only touch their own slot, and slots are a cache line each, so reading threads never write to a
+     * line another thread reads. Slots get handed out on a thread's first read and handed back when it exits.
+     */
+    class epoch_domain {
+      public:
+        static constexpr size_t max_threads = 512;
+
+      private:
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> epoch{0};  // 0: not reading
+            std::atomic<bool> taken{false};
+            int depth = 0;                   // nested reads of the owning thread, only it touches this
+        };
+
+        std::atomic<uint64_t> global_epoch{1};
+        Slot slots[max_threads];
+
+        // hands the slot back when its thread exits
+        struct Owner {
+            Slot* slot = nullptr;
+            ~Owner()
+            {
+                if (slot != nullptr) {
+                    slot->taken.store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        Slot& own_slot()
+        {
+            thread_local Owner owner;
+            if (owner.slot == nullptr) {
+                for (Slot& slot : slots) {
+                    bool expected = false;
+                    if (slot.taken.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                        owner.slot = &slot;
+                        break;
+                    }
+                }
+                if (owner.slot == nullptr) {
+                    throw std::length_error("more than epoch_domain::max_threads threads reading at once");
+                }
+            }
+            return *owner.slot;
+        }
+
+      public:
+        /**
+         * @brief marks this thread as reading until the guard is destroyed
+         */
+        class Guard {
+            Slot& slot;
+
+          public:
+            explicit Guard(epoch_domain& domain) : slot{domain.own_slot()}
+            {
+                if (slot.depth++ == 0) {
+                    // seq_cst, so the store can't move below the reader's load of the published pointer
+                    slot.epoch.store(domain.global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+                }
+            }
+            ~Guard()
+            {
+                if (--slot.depth == 0) {
+                    slot.epoch.store(0, std::memory_order_release);
+                }
+            }
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+        };
+
+        /**
+         * @brief call after unpublishing something
+         * @return the epoch it got unpublished in, for safe_to_free()
+         */
+        uint64_t retire() { return global_epoch.fetch_add(1, std::memory_order_seq_cst); }
+
+        /**
+         * @return the oldest epoch a reader is still in, UINT64_MAX if there are none
+         */
+        uint64_t oldest_reader() const
+        {
+            uint64_t oldest = UINT64_MAX;
+            for (const Slot& slot : slots) {
+                uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+                if (epoch != 0 && epoch < oldest) {
+                    oldest = epoch;
+                }
+            }
+            return oldest;
+        }
+    };
+
+    inline epoch_domain& global_epoch_domain()
+    {
+        static epoch_domain domain;
+        return domain;
+    }
+
+}  // namespace LP
+
+/**
+ * @brief LP3 for read-mostly maps: lookups never lock or wait, writes copy the map and publish the copy
+ * @tparam K Key
+ * @tparam V Value
+ * @tparam Hash Hashing function that should be used to hash keys
+ * @tparam Pred equality function to check if keys are equal
+ * @tparam Allocator=std::allocator the allocator
+ *
+ * @details
+ * Readers load an atomic pointer to the current LP3 and look up in it. Nobody ever writes to a published LP3,
+ * so a lookup is an ordinary LP3 lookup plus 2 stores to the reader's own epoch slot (LP::epoch_domain),
+ * and nothing readers write is shared between them. That's what lets reads scale with the number of cores.
+ *
+ * Every write copies the current LP3 under a mutex, changes the copy and swaps the pointer. That's O(size) per
+ * write, which is the point: meant for maps that get read all the time and written a few times a second.
+ * update() puts a whole batch of changes in 1 copy.
+ * The replaced LP3s are freed by the next writer once every reader that could have seen them is done,
+ * or when the map is destroyed.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>,
+          class Allocator = std::allocator<std::pair<const K, V>>>
+class LP3Rcu {
+    using Pair_elem = std::pair<const K, V>;
+
+  public:
+    using Map = LP3<K, V, Hash, Pred, Allocator>;
+
+  private:
+    std::atomic<const Map*> published;
+    std::mutex writer_lock;                                       // writers copy one at a time
+    std::vector<std::pair<uint64_t, const Map*>> retired;         // unpublished maps and their epochs
+    LP::epoch_domain& domain;
+
+    void publish(Map* next);
+    void free_retired(bool all);
+
+  public:
+    // constructors and destructors
+    LP3Rcu();
+    explicit LP3Rcu(const Map& initial);
+    LP3Rcu(const LP3Rcu&) = delete;
+    LP3Rcu& operator=(const LP3Rcu&) = delete;
+    ~LP3Rcu();
+
+    // capacity
+    size_t size() const;
+    bool empty() const { return size() == 0; };
+
+    // modifiers, each one copies the map
+    template <class F>
+    void update(F f);
+    void clear();
+    bool insert(const Pair_elem& kv);
+    template <class M>
+    bool insert_or_assign(const K& k, M&& obj);
+    size_t erase(const K& key);
+
+    // lookups
+    template <class F>
+    auto read(F f) const;
+    bool find(const K& key, V& out) const;
+    V at(const K& key) const;
+    size_t count(const K& key) const;
+    bool contains(const K& key) const { return count(key) == 1; };
+
+    // hash policy
+    void reserve(size_t size);
+};
+
+#ifndef LPRCU_DEF_H
+
+/**
+ * @brief empty map
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Rcu<K, V, Hash, Pred, Allocator>::LP3Rcu() : published{new Map()}, domain{LP::global_epoch_domain()}
+{
+}
+
+/**
+ * @brief publishes a copy of initial
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Rcu<K, V, Hash, Pred, Allocator>::LP3Rcu(const Map& initial)
+    : published{new Map(initial)}, domain{LP::global_epoch_domain()}
+{
+}
+
+/**
+ * @details frees every version, so no thread can be reading this map anymore
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Rcu<K, V, Hash, Pred, Allocator>::~LP3Rcu()
+{
+    free_retired(true);
+    delete published.load();
+}
+
+/**
+ * @brief swaps next in for the current map, and frees the old ones no reader can see anymore
+ * @details writer_lock has to be held
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Rcu<K, V, Hash, Pred, Allocator>::publish(Map* next)
+{
+    const Map* old = published.exchange(next, std::memory_order_seq_cst);
+    retired.emplace_back(domain.retire(), old);
+    free_retired(false);
+}
+
+/**
+ * @param all free everything, without looking at the readers
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Rcu<K, V, Hash, Pred, Allocator>::free_retired(bool all)
+{
+    uint64_t oldest = all ? UINT64_MAX : domain.oldest_reader();
+    auto still_read = std::partition(retired.begin(), retired.end(),
+                                     [oldest](const std::pair<uint64_t, const Map*>& r) { return r.first >= oldest; });
+    for (auto it = still_read; it != retired.end(); it++) {
+        delete it->second;
+    }
+    retired.erase(still_read, retired.end());
+}
+
+/**
+ * @return number of elements in the current version
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Rcu<K, V, Hash, Pred, Allocator>::size() const
+{
+    return read([](const Map& map) { return map.size(); });
+}
+
+/**
+ * @brief copies the current map, calls f(Map&) on the copy and publishes it
+ * @details readers see either none or all of what f did
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class F>
+void LP3Rcu<K, V, Hash, Pred, Allocator>::update(F f)
+{
+    std::lock_guard<std::mutex> guard(writer_lock);
+    auto next = std::make_unique<Map>(*published.load(std::memory_order_acquire));
+    f(*next);
+    publish(next.release());
+}
+
+/**
+ * @brief publishes an empty map
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Rcu<K, V, Hash, Pred, Allocator>::clear()
+{
+    update([](Map& map) { map.clear(); });
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map
+ * @return true if it got inserted
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool LP3Rcu<K, V, Hash, Pred, Allocator>::insert(const Pair_elem& kv)
+{
+    bool inserted = false;
+    update([&](Map& map) { inserted = map.insert(kv).second; });
+    return inserted;
+}
+
+/**
+ * @details assigns obj to map[k] if k exists, inserts (k, obj) otherwise
+ * @return true if it got inserted
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class M>
+bool LP3Rcu<K, V, Hash, Pred, Allocator>::insert_or_assign(const K& k, M&& obj)
+{
+    bool inserted = false;
+    update([&](Map& map) { inserted = map.insert_or_assign(k, std::forward<M>(obj)).second; });
+    return inserted;
+}
+
+/**
+ * @brief erase element with key
+ * @return number of erased elements
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Rcu<K, V, Hash, Pred, Allocator>::erase(const K& key)
+{
+    size_t erased = 0;
+    update([&](Map& map) { erased = map.erase(key); });
+    return erased;
+}
+
+/**
+ * @brief calls f(const Map&) on the current version and returns what f returns
+ * @details
+ * for anything find() and friends don't cover, like iterating or several lookups in 1 consistent version.
+ * Nothing f gets from the map (iterators, references) may outlive the call.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class F>
+auto LP3Rcu<K, V, Hash, Pred, Allocator>::read(F f) const
+{
+    LP::epoch_domain::Guard guard(domain);
+    return f(*published.load(std::memory_order_seq_cst));
+}
+
+/**
+ * @param out gets a copy of the value if key exists, isn't touched otherwise
+ * @return true if key exists
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool LP3Rcu<K, V, Hash, Pred, Allocator>::find(const K& key, V& out) const
+{
+    return read([&](const Map& map) {
+        auto it = map.find(key);
+        if (it == map.cend()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    });
+}
+
+/**
+ * @return copy of the value of key
+ * @throws std::out_of_range if key doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V LP3Rcu<K, V, Hash, Pred, Allocator>::at(const K& key) const
+{
+    return read([&](const Map& map) { return map.at(key); });
+}
+
+/**
+ * @return 1 if key exists, 0 otherwise
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Rcu<K, V, Hash, Pred, Allocator>::count(const K& key) const
+{
+    return read([&](const Map& map) { return map.count(key); });
+}
+
+/**
+ * @brief publishes a copy with room for size elements
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Rcu<K, V, Hash, Pred, Allocator>::reserve(size_t size)
+{
+    update([size](Map& map) { map.reserve(size); });
+}
+
+#endif  // LPRCU_DEF_H
+#endif  // LPRCU_H
@@ -0,0 +1,270 @@
+#ifndef LPSHARDED_H
+#define LPSHARDED_H
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+
+#include "LPmap3.h"
+
+/**
+ * @brief LP3 split into independently locked shards, for many threads at once
+ * @tparam K Key
+ * @tparam V Value
+ * @tparam Hash Hashing function that should be used to hash keys
+ * @tparam Pred equality function to check if keys are equal
+ * @tparam Allocator=std::allocator the allocator
+ *
+ * @details
+ * One LP3 behind one mutex stops scaling after a few threads, because every operation waits for that mutex and
+ * every lock/unlock bounces its cache line between all cores. Here each key belongs to one of a power of 2 number of
+ * LP3 shards, each with its own std::shared_mutex. Lookups take a shared lock, modifications an exclusive one,
+ * and threads working on different shards never touch each other's cache lines: shards are aligned to 64 bytes,
+ * so no 2 locks share a line.
+ *
+ * The shard is picked from the high bits of the user's hash times a 64 bit odd constant (fibonacci hashing).
+ * LP3 itself uses the identity for integers, so without the multiply sequential keys would all land in 1 shard.
+ *
+ * Nothing hands out references or iterators, since those would outlive the lock that protects them. Values
+ * are copied out, or modified in place through a function that runs under the lock (update()).
+ * size() and for_each() lock one shard at a time, so under concurrent writes they see every shard at a
+ * different moment, not a snapshot of the whole map.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>,
+          class Allocator = std::allocator<std::pair<const K, V>>>
+class LP3Sharded {
+    using Pair_elem = std::pair<const K, V>;
+    using Map = LP3<K, V, Hash, Pred, Allocator>;
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex lock;
+        Map map;
+    };
+
+    Hash user_hash;
+    size_t shard_n;
+    int shift;                         // 64 - log2(shard_n), how far the routing hash gets shifted
+    std::unique_ptr<Shard[]> shards;  // shards can't move because of their locks, so no vector
+
+    Shard& shard_of(const K& key) const;
+
+  public:
+    // constructors and destructors
+    explicit LP3Sharded(size_t shard_count = 32, const Hash& hash = Hash());
+    LP3Sharded(const LP3Sharded&) = delete;
+    LP3Sharded& operator=(const LP3Sharded&) = delete;
+
+    // capacity
+    size_t size() const;
+    bool empty() const { return size() == 0; };
+    size_t shard_count() const { return shard_n; };
+
+    // modifiers
+    void clear();
+    bool insert(const Pair_elem& kv);
+    template <class M>
+    bool insert_or_assign(const K& k, M&& obj);
+    template <class F>
+    void update(const K& k, F f);
+    size_t erase(const K& key);
+
+    // lookups
+    bool find(const K& key, V& out) const;
+    V at(const K& key) const;
+    size_t count(const K& key) const;
+    bool contains(const K& key) const { return count(key) == 1; };
+
+    // iteration
+    template <class F>
+    void for_each(F f) const;
+
+    // hash policy
+    void reserve(size_t size);
+};
+
+#ifndef LPSHARDED_DEF_H
+
+/**
+ * @return the shard key belongs to
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename LP3Sharded<K, V, Hash, Pred, Allocator>::Shard& LP3Sharded<K, V, Hash, Pred, Allocator>::shard_of(
+    const K& key) const
+{
+    if (shard_n == 1) {
+        return shards[0];
+    }
+    uint64_t hash = static_cast<uint64_t>(user_hash(key)) * 0x9E3779B97F4A7C15ull;
+    return shards[hash >> shift];
+}
+
+/**
+ * @param shard_count number of shards, rounded up to a power of 2
+ * @details
+ * all shards get constructed here. They hash with the tables every LP3 shares, LP::default_tabulation(), until
+ * one of them reseeds.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Sharded<K, V, Hash, Pred, Allocator>::LP3Sharded(size_t shard_count, const Hash& hash)
+    : user_hash(hash), shard_n{1}, shift{64}, shards{}
+{
+    while (shard_n < shard_count) {
+        shard_n <<= 1;
+        shift--;
+    }
+    shards = std::unique_ptr<Shard[]>(new Shard[shard_n]);
+}
+
+/**
+ * @return the number of elements, summed over the shards one at a time
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Sharded<K, V, Hash, Pred, Allocator>::size() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < shard_n; i++) {
+        std::shared_lock<std::shared_mutex> guard(shards[i].lock);
+        total += shards[i].map.size();
+    }
+    return total;
+}
+
+/**
+ * @brief clears every shard
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Sharded<K, V, Hash, Pred, Allocator>::clear()
+{
+    for (size_t i = 0; i < shard_n; i++) {
+        std::unique_lock<std::shared_mutex> guard(shards[i].lock);
+        shards[i].map.clear();
+    }
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map
+ * @return true if it got inserted
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool LP3Sharded<K, V, Hash, Pred, Allocator>::insert(const Pair_elem& kv)
+{
+    Shard& shard = shard_of(kv.first);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.map.insert(kv).second;
+}
+
+/**
+ * @details assigns obj to map[k] if k exists, inserts (k, obj) otherwise
+ * @return true if it got inserted
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class M>
+bool LP3Sharded<K, V, Hash, Pred, Allocator>::insert_or_assign(const K& k, M&& obj)
+{
+    Shard& shard = shard_of(k);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.map.insert_or_assign(k, std::forward<M>(obj)).second;
+}
+
+/**
+ * @brief calls f(V&) with the value of k while holding k's shard. Inserts V{} first if k doesn't exist
+ * @details
+ * read-modify-write without a race, like update(word, [](int& n) { n++; }).
+ * f shouldn't touch this map, the shard's lock isn't recursive.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class F>
+void LP3Sharded<K, V, Hash, Pred, Allocator>::update(const K& k, F f)
+{
+    Shard& shard = shard_of(k);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    f(shard.map[k]);
+}
+
+/**
+ * @brief erase element with key
+ * @return number of erased elements
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Sharded<K, V, Hash, Pred, Allocator>::erase(const K& key)
+{
+    Shard& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    return shard.map.erase(key);
+}
+
+/**
+ * @param out gets a copy of the value if key exists, isn't touched otherwise
+ * @return true if key exists
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+bool LP3Sharded<K, V, Hash, Pred, Allocator>::find(const K& key, V& out) const
+{
+    const Shard& shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> guard(shard.lock);
+    auto it = shard.map.find(key);
+    if (it == shard.map.cend()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+/**
+ * @return copy of the value of key
+ * @throws std::out_of_range if key doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V LP3Sharded<K, V, Hash, Pred, Allocator>::at(const K& key) const
+{
+    const Shard& shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> guard(shard.lock);
+    return shard.map.at(key);
+}
+
+/**
+ * @return 1 if key exists, 0 otherwise
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Sharded<K, V, Hash, Pred, Allocator>::count(const K& key) const
+{
+    const Shard& shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> guard(shard.lock);
+    return shard.map.count(key);
+}
+
+/**
+ * @brief calls f(const std::pair<const K, V>&) for every element, holding a shared lock on its shard
+ * @details f shouldn't write to this map, that would deadlock on the shard being iterated.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class F>
+void LP3Sharded<K, V, Hash, Pred, Allocator>::for_each(F f) const
+{
+    for (size_t i = 0; i < shard_n; i++) {
+        std::shared_lock<std::shared_mutex> guard(shards[i].lock);
+        for (auto it = shards[i].map.cbegin(); it != shards[i].map.cend(); it++) {
+            f(*it);
+        }
+    }
+}
+
+/**
+ * @brief make room for size elements spread over the shards
+ * @details
+ * every shard gets an equal part plus 1/8th, since the keys won't spread perfectly evenly
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Sharded<K, V, Hash, Pred, Allocator>::reserve(size_t size)
+{
+    size_t per_shard = size / shard_n;
+    per_shard += per_shard / 8 + 1;
+    for (size_t i = 0; i < shard_n; i++) {
+        std::unique_lock<std::shared_mutex> guard(shards[i].lock);
+        shards[i].map.reserve(per_shard);
+    }
+}
+
+#endif  // LPSHARDED_DEF_H
+#endif  // LPSHARDED_H
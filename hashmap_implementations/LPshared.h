@@ -0,0 +1,600 @@
+#ifndef LPSHARED_H
+#define LPSHARED_H
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "LPmap3.h"
+
+namespace LP {
+
+    /*
+     * start of an LP3Shared segment. Everything a process needs to use the map is in the segment,
+     * including the tabulation state: a process that drew its own would hash every key somewhere else.
+     */
+    struct Shared_header {
+        static constexpr uint64_t magic_value = 0x4c50335348415245ull;  // "LP3SHARE"
+
+        uint64_t magic;       // written last by the creator, so half made segments can be told apart
+        uint32_t key_size;    // sizeof(K) and sizeof(V) of the creator, checked when attaching
+        uint32_t value_size;
+        uint64_t bucket_n;
+        uint64_t capacity;    // nodes, the most elements the map can hold
+        uint64_t modulo_help;
+        uint64_t size;        // live elements
+        uint64_t deleted_n;   // tombstones in hash_store
+        uint64_t node_n;      // nodes ever handed out, the ones after it were never used
+        uint64_t free_n;      // erased nodes waiting on the free stack
+        pthread_rwlock_t lock;
+        LP::tabulation_table random_state;
+    };
+
+    /*
+     * where the arrays start, in bytes from the start of the segment. Every array starts on a cache line.
+     */
+    struct Shared_layout {
+        size_t hash_store;
+        size_t node_index;
+        size_t nodes;
+        size_t free_stack;
+        size_t bytes;
+
+        Shared_layout(uint64_t bucket_n, uint64_t capacity, size_t node_size)
+        {
+            auto line = [](size_t n) { return (n + 63) / 64 * 64; };
+            hash_store = line(sizeof(Shared_header));
+            node_index = line(hash_store + bucket_n * sizeof(int32_t));
+            nodes = line(node_index + bucket_n * sizeof(uint32_t));
+            free_stack = line(nodes + capacity * node_size);
+            bytes = line(free_stack + capacity * sizeof(uint32_t));
+        }
+    };
+
+    [[noreturn]] inline void throw_errno(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+}  // namespace LP
+
+/**
+ * @brief LP3 in a POSIX shared memory segment, so several processes can use 1 copy of a map
+ * @tparam K Key, trivially copyable
+ * @tparam V Value, trivially copyable
+ * @tparam Hash Hashing function that should be used to hash keys. Has to give the same hash in every process
+ * @tparam Pred equality function to check if keys are equal
+ *
+ * @details
+ * Same layout as LP3: hash_store with the hashes, a parallel array with handles, and the elements somewhere else.
+ * A process maps the segment wherever mmap puts it, so a handle can't be an address like LP3's colony iterators.
+ * Here a handle is the offset of the element in the node array, and each process adds its own base address.
+ * Nothing in the segment points anywhere, which is also why K and V have to be trivially copyable:
+ * a std::string would point into the heap of the process that made it.
+ *
+ * The size is fixed when the segment is created. Growing would mean every attached process remapping at the same
+ * time, which is more than a map that gets loaded once and read by many processes needs. insert throws
+ * std::length_error when capacity elements are in it. Erased elements' nodes are reused, and when tombstones
+ * fill the table it gets cleaned up at the same size.
+ *
+ * Processes that attach read-write share a process-shared pthread rwlock in the header: lookups take it shared,
+ * modifications exclusively. Read-only attachments map the segment read only and can't take it, so they don't
+ * lock at all. Use those once the map is complete, which is what saves the memory: N readers, 1 copy.
+ * A process that dies while holding the lock leaves it held.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>>
+class LP3Shared {
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "LP3Shared can only hold trivially copyable keys and values");
+
+  public:
+    enum class Access { read_only, read_write };
+    struct Node {
+        K first;
+        V second;
+    };
+
+  private:
+    static constexpr float lf_max = 0.5;
+
+    int fd;
+    void* base;
+    size_t bytes;
+    bool writable;
+    LP::Shared_header* header;
+    int32_t* hash_store;
+    uint32_t* node_index;  // offset of each bucket's element in nodes
+    Node* nodes;
+    uint32_t* free_stack;  // offsets of erased nodes
+    Hash user_hash;
+    Pred is_equal;
+
+    // takes the rwlock of read-write attachments, does nothing for read-only ones
+    class Guard {
+        pthread_rwlock_t* lock;
+
+      public:
+        Guard(const LP3Shared& map, bool exclusive);
+        ~Guard()
+        {
+            if (lock != nullptr) {
+                pthread_rwlock_unlock(lock);
+            }
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    LP3Shared(int fd, void* base, size_t bytes, bool writable);
+    void set_pointers();
+    void close() noexcept;
+    void check_writable() const;
+    int32_t hasher(const K& key) const;
+    size_t prober(const K& key, int32_t hash) const;
+    bool insert_unlocked(const K& key, const V& value, int32_t hash, size_t pos);  // takes no lock, see insert()
+    void rehash_in_place();
+
+  public:
+    // constructors and destructors
+    static LP3Shared create(const std::string& name, size_t capacity);
+    static LP3Shared open(const std::string& name, Access access = Access::read_only);
+    static void remove(const std::string& name);
+    LP3Shared(LP3Shared&& other) noexcept;
+    LP3Shared& operator=(LP3Shared&& other) noexcept;
+    LP3Shared(const LP3Shared&) = delete;
+    LP3Shared& operator=(const LP3Shared&) = delete;
+    ~LP3Shared() { close(); };
+
+    // capacity
+    size_t size() const;
+    bool empty() const { return size() == 0; };
+    size_t capacity() const { return header->capacity; };
+    size_t segment_bytes() const { return bytes; };
+
+    // modifiers
+    bool insert(const K& key, const V& value);
+    bool insert_or_assign(const K& key, const V& value);
+    size_t erase(const K& key);
+    void clear();
+
+    // lookups
+    bool find(const K& key, V& out) const;
+    V at(const K& key) const;
+    size_t count(const K& key) const;
+    bool contains(const K& key) const { return count(key) == 1; };
+
+    // iteration
+    template <class F>
+    void for_each(F f) const;
+
+    // hash policy
+    size_t bucket_count() const { return header->bucket_n; };
+    float load_factor() const { return static_cast<float>(size()) / bucket_count(); };
+    float max_load_factor() const { return lf_max; };
+};
+
+#ifndef LPSHARED_DEF_H
+
+template <typename K, typename V, typename Hash, typename Pred>
+LP3Shared<K, V, Hash, Pred>::Guard::Guard(const LP3Shared& map, bool exclusive) : lock{nullptr}
+{
+    if (!map.writable) {
+        return;
+    }
+    lock = &map.header->lock;
+    int error = exclusive ? pthread_rwlock_wrlock(lock) : pthread_rwlock_rdlock(lock);
+    if (error != 0) {
+        lock = nullptr;
+        throw std::system_error(error, std::generic_category(), "pthread_rwlock");
+    }
+}
+
+/**
+ * @brief takes over an already mapped segment
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+LP3Shared<K, V, Hash, Pred>::LP3Shared(int fd, void* base, size_t bytes, bool writable)
+    : fd{fd}, base{base}, bytes{bytes}, writable{writable}, header{static_cast<LP::Shared_header*>(base)}
+{
+    set_pointers();
+}
+
+/**
+ * @brief this process's addresses of the arrays, from the segment's layout
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+void LP3Shared<K, V, Hash, Pred>::set_pointers()
+{
+    LP::Shared_layout layout(header->bucket_n, header->capacity, sizeof(Node));
+    char* start = static_cast<char*>(base);
+    hash_store = reinterpret_cast<int32_t*>(start + layout.hash_store);
+    node_index = reinterpret_cast<uint32_t*>(start + layout.node_index);
+    nodes = reinterpret_cast<Node*>(start + layout.nodes);
+    free_stack = reinterpret_cast<uint32_t*>(start + layout.free_stack);
+}
+
+/**
+ * @brief unmaps the segment. The segment itself stays until remove()
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+void LP3Shared<K, V, Hash, Pred>::close() noexcept
+{
+    if (base != nullptr) {
+        munmap(base, bytes);
+        ::close(fd);
+        base = nullptr;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred>
+void LP3Shared<K, V, Hash, Pred>::check_writable() const
+{
+    if (!writable) {
+        throw std::logic_error("LP3Shared is attached read only");
+    }
+}
+
+/**
+ * @brief creates the segment name, with room for capacity elements
+ * @throws std::length_error if capacity needs more than INT32_MAX buckets, which is anything above about 912
+ * million elements. std::system_error if the segment already exists or can't be made
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+LP3Shared<K, V, Hash, Pred> LP3Shared<K, V, Hash, Pred>::create(const std::string& name, size_t capacity)
+{
+    // home_slot() works on int32_t, so the bucket count has to fit in one
+    uint64_t bucket_n = capacity > INT32_MAX ? capacity : LP::next_prime(static_cast<size_t>(capacity / lf_max) + 1);
+    if (bucket_n > INT32_MAX) {
+        throw std::length_error("LP3Shared: capacity needs more than INT32_MAX buckets");
+    }
+    LP::Shared_layout layout(bucket_n, capacity, sizeof(Node));
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        LP::throw_errno("shm_open");
+    }
+    if (ftruncate(fd, layout.bytes) == -1) {
+        int error = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), "ftruncate");
+    }
+    void* base = mmap(nullptr, layout.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        int error = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), "mmap");
+    }
+
+    // ftruncate zeroed everything, only what isn't 0 needs writing
+    auto header = static_cast<LP::Shared_header*>(base);
+    header->key_size = sizeof(K);
+    header->value_size = sizeof(V);
+    header->bucket_n = bucket_n;
+    header->capacity = capacity;
+    header->modulo_help = fastmod::computeM_s32(bucket_n);
+    header->random_state = LP::default_tabulation();
+    pthread_rwlockattr_t attributes;
+    pthread_rwlockattr_init(&attributes);
+    pthread_rwlockattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    pthread_rwlock_init(&header->lock, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+
+    LP3Shared map(fd, base, layout.bytes, true);
+    std::fill(map.hash_store, map.hash_store + bucket_n, LP::EMPTY);
+    __atomic_store_n(&header->magic, LP::Shared_header::magic_value, __ATOMIC_RELEASE);
+    return map;
+}
+
+/**
+ * @brief attaches to a segment made by create(), in this or another process
+ * @throws std::system_error if it doesn't exist, std::runtime_error if it isn't a finished LP3Shared<K, V>
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+LP3Shared<K, V, Hash, Pred> LP3Shared<K, V, Hash, Pred>::open(const std::string& name, Access access)
+{
+    bool writable = access == Access::read_write;
+    int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd == -1) {
+        LP::throw_errno("shm_open");
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "fstat");
+    }
+    size_t bytes = info.st_size;
+    void* base = bytes < sizeof(LP::Shared_header)
+                     ? MAP_FAILED
+                     : mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("LP3Shared: " + name + " is too small or can't be mapped");
+    }
+    auto header = static_cast<LP::Shared_header*>(base);
+    bool valid = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == LP::Shared_header::magic_value
+                 && header->key_size == sizeof(K) && header->value_size == sizeof(V)
+                 && LP::Shared_layout(header->bucket_n, header->capacity, sizeof(Node)).bytes == bytes;
+    if (!valid) {
+        munmap(base, bytes);
+        ::close(fd);
+        throw std::runtime_error("LP3Shared: " + name + " isn't a finished map with these key and value sizes");
+    }
+    return LP3Shared(fd, base, bytes, writable);
+}
+
+/**
+ * @brief removes the segment's name. Processes that have it mapped keep using it, the memory goes with the last
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+void LP3Shared<K, V, Hash, Pred>::remove(const std::string& name)
+{
+    if (shm_unlink(name.c_str()) == -1 && errno != ENOENT) {
+        LP::throw_errno("shm_unlink");
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred>
+LP3Shared<K, V, Hash, Pred>::LP3Shared(LP3Shared&& other) noexcept
+    : fd{other.fd},
+      base{other.base},
+      bytes{other.bytes},
+      writable{other.writable},
+      header{other.header},
+      hash_store{other.hash_store},
+      node_index{other.node_index},
+      nodes{other.nodes},
+      free_stack{other.free_stack},
+      user_hash{std::move(other.user_hash)},
+      is_equal{std::move(other.is_equal)}
+{
+    other.base = nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Pred>
+LP3Shared<K, V, Hash, Pred>& LP3Shared<K, V, Hash, Pred>::operator=(LP3Shared&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        fd = other.fd;
+        base = other.base;
+        bytes = other.bytes;
+        writable = other.writable;
+        header = other.header;
+        set_pointers();
+        user_hash = std::move(other.user_hash);
+        is_equal = std::move(other.is_equal);
+        other.base = nullptr;
+    }
+    return *this;
+}
+
+/**
+ * @details like LP3: integral keys are their own hash, others get tabulated, with the state in the segment
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+int32_t LP3Shared<K, V, Hash, Pred>::hasher(const K& key) const
+{
+    int32_t hash;
+    if constexpr (std::is_integral<K>::value) {
+        hash = static_cast<int32_t>(key);
+    }
+    else {
+        hash = LP::tabulate(static_cast<uint64_t>(user_hash(key)), header->random_state);
+    }
+    return (hash == LP::DELETED || hash == LP::EMPTY) ? ~hash : hash;
+}
+
+/**
+ * @return the bucket key is in, or the empty bucket where it would go
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+size_t LP3Shared<K, V, Hash, Pred>::prober(const K& key, int32_t hash) const
+{
+    const size_t size = header->bucket_n;
+    size_t pos = LP::home_slot(hash, header->modulo_help, size);
+    for (size_t i = 0; i < size; i++) {
+        const int32_t bucket_hash = hash_store[pos];
+        if (bucket_hash == LP::EMPTY || (bucket_hash == hash && is_equal(nodes[node_index[pos]].first, key))) {
+            return pos;
+        }
+        pos = (pos + 1 == size) ? 0 : pos + 1;
+    }
+    return pos;
+}
+
+/**
+ * @brief clears the tombstones, keeping the bucket count. The elements don't move, only their handles
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+void LP3Shared<K, V, Hash, Pred>::rehash_in_place()
+{
+    std::vector<std::pair<int32_t, uint32_t>> live;
+    live.reserve(header->size);
+    for (size_t pos = 0; pos < header->bucket_n; pos++) {
+        if (hash_store[pos] != LP::EMPTY && hash_store[pos] != LP::DELETED) {
+            live.emplace_back(hash_store[pos], node_index[pos]);
+        }
+    }
+    std::fill(hash_store, hash_store + header->bucket_n, LP::EMPTY);
+    for (const auto& bucket : live) {
+        size_t pos = LP::home_slot(bucket.first, header->modulo_help, header->bucket_n);
+        while (hash_store[pos] != LP::EMPTY) {
+            pos = (pos + 1 == header->bucket_n) ? 0 : pos + 1;
+        }
+        hash_store[pos] = bucket.first;
+        node_index[pos] = bucket.second;
+    }
+    header->deleted_n = 0;
+}
+
+/**
+ * @return number of elements
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+size_t LP3Shared<K, V, Hash, Pred>::size() const
+{
+    Guard guard(*this, false);
+    return header->size;
+}
+
+/**
+ * @brief insert() and insert_or_assign() after the lookup. Takes no lock: they hold the write lock throughout
+ * @param pos what prober() returned for key
+ * @return true if it got inserted, false if key was already at pos
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+bool LP3Shared<K, V, Hash, Pred>::insert_unlocked(const K& key, const V& value, int32_t hash, size_t pos)
+{
+    if (hash_store[pos] != LP::EMPTY) {
+        return false;
+    }
+    if (header->size == header->capacity) {
+        throw std::length_error("LP3Shared is at capacity");
+    }
+    if (header->size + header->deleted_n + 1 > header->bucket_n * lf_max) {
+        rehash_in_place();
+        pos = prober(key, hash);
+    }
+    uint32_t node = header->free_n > 0 ? free_stack[--header->free_n] : static_cast<uint32_t>(header->node_n++);
+    nodes[node] = Node{key, value};
+    node_index[pos] = node;
+    hash_store[pos] = hash;
+    header->size++;
+    return true;
+}
+
+/**
+ * @brief inserts (key, value) if key doesn't exist in map
+ * @return true if it got inserted
+ * @throws std::length_error if the map is at capacity, std::logic_error if it's attached read only
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+bool LP3Shared<K, V, Hash, Pred>::insert(const K& key, const V& value)
+{
+    check_writable();
+    Guard guard(*this, true);
+    int32_t hash = hasher(key);
+    return insert_unlocked(key, value, hash, prober(key, hash));
+}
+
+/**
+ * @details assigns value to map[key] if key exists, inserts (key, value) otherwise.
+ * The lookup and the insert happen under 1 write lock, so a concurrent insert of key can't slip in between them.
+ * @return true if it got inserted
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+bool LP3Shared<K, V, Hash, Pred>::insert_or_assign(const K& key, const V& value)
+{
+    check_writable();
+    Guard guard(*this, true);
+    int32_t hash = hasher(key);
+    size_t pos = prober(key, hash);
+    if (hash_store[pos] != LP::EMPTY) {
+        nodes[node_index[pos]].second = value;
+        return false;
+    }
+    return insert_unlocked(key, value, hash, pos);
+}
+
+/**
+ * @brief erase element with key
+ * @return number of erased elements
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+size_t LP3Shared<K, V, Hash, Pred>::erase(const K& key)
+{
+    check_writable();
+    Guard guard(*this, true);
+    size_t pos = prober(key, hasher(key));
+    if (hash_store[pos] == LP::EMPTY) {
+        return 0;
+    }
+    hash_store[pos] = LP::DELETED;
+    free_stack[header->free_n++] = node_index[pos];
+    header->size--;
+    header->deleted_n++;
+    return 1;
+}
+
+/**
+ * @brief removes every element, keeping the capacity
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+void LP3Shared<K, V, Hash, Pred>::clear()
+{
+    check_writable();
+    Guard guard(*this, true);
+    std::fill(hash_store, hash_store + header->bucket_n, LP::EMPTY);
+    header->size = 0;
+    header->deleted_n = 0;
+    header->node_n = 0;
+    header->free_n = 0;
+}
+
+/**
+ * @param out gets a copy of the value if key exists, isn't touched otherwise
+ * @return true if key exists
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+bool LP3Shared<K, V, Hash, Pred>::find(const K& key, V& out) const
+{
+    Guard guard(*this, false);
+    size_t pos = prober(key, hasher(key));
+    if (hash_store[pos] == LP::EMPTY) {
+        return false;
+    }
+    out = nodes[node_index[pos]].second;
+    return true;
+}
+
+/**
+ * @return copy of the value of key
+ * @throws std::out_of_range if key doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+V LP3Shared<K, V, Hash, Pred>::at(const K& key) const
+{
+    V value;
+    if (!find(key, value)) {
+        throw std::out_of_range("key not found");
+    }
+    return value;
+}
+
+/**
+ * @return 1 if key exists, 0 otherwise
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+size_t LP3Shared<K, V, Hash, Pred>::count(const K& key) const
+{
+    V value;
+    return find(key, value);
+}
+
+/**
+ * @brief calls f(const Node&) for every element, holding the lock shared the whole time
+ */
+template <typename K, typename V, typename Hash, typename Pred>
+template <class F>
+void LP3Shared<K, V, Hash, Pred>::for_each(F f) const
+{
+    Guard guard(*this, false);
+    for (size_t pos = 0; pos < header->bucket_n; pos++) {
+        if (hash_store[pos] != LP::EMPTY && hash_store[pos] != LP::DELETED) {
+            f(static_cast<const Node&>(nodes[node_index[pos]]));
+        }
+    }
+}
+
+#endif  // LPSHARED_DEF_H
+#endif  // LPSHARED_H
@@ -0,0 +1,758 @@
+#ifndef LPSPLIT_H
+#define LPSPLIT_H
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "LPmap3.h"
+
+namespace LP {
+
+    /**
+     * @brief stable storage for values, addressed with a 32 bit index
+     * @tparam V value type
+     * @tparam Allocator allocator for V, rebound to the chunk storage
+     * @details
+     * Values are placement-new'd into fixed size chunks. Chunks never move or get freed until release(),
+     * so references to values stay valid like they do in LP3.
+     * Erased slots go on a free list and are handed out again by the next emplace().
+     * The slab doesn't know which slots are alive, so whoever owns it has to erase() the live ones
+     * before calling release().
+     */
+    template <typename V, class Allocator = std::allocator<V>>
+    class value_slab {
+        static constexpr uint32_t chunk_bits = 12;
+        static constexpr uint32_t chunk_size = 1u << chunk_bits;
+        static constexpr uint32_t chunk_mask = chunk_size - 1;
+        using storage = typename std::aligned_storage<sizeof(V), alignof(V)>::type;
+        using storage_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<storage>;
+
+        std::vector<storage*> chunks;
+        std::vector<uint32_t> free_slots;
+        uint32_t used;  // slots handed out of the chunks so far, freed ones included
+
+        V* slot(uint32_t index) const { return reinterpret_cast<V*>(&chunks[index >> chunk_bits][index & chunk_mask]); }
+
+      public:
+        value_slab() : chunks{}, free_slots{}, used{0} {};
+        value_slab(const value_slab&) = delete;
+        value_slab& operator=(const value_slab&) = delete;
+        ~value_slab() { release(); };
+
+        /**
+         * @brief constructs a value in a free slot
+         * @return index of the slot
+         */
+        template <class... Args>
+        uint32_t emplace(Args&&... args)
+        {
+            uint32_t index;
+            if (!free_slots.empty()) {
+                index = free_slots.back();
+                free_slots.pop_back();
+            }
+            else {
+                if ((used >> chunk_bits) == chunks.size()) {
+                    storage_alloc alloc;
+                    chunks.push_back(std::allocator_traits<storage_alloc>::allocate(alloc, chunk_size));
+                }
+                index = used++;
+            }
+            ::new (static_cast<void*>(slot(index))) V(std::forward<Args>(args)...);
+            return index;
+        }
+
+        /**
+         * @brief destroys the value at index and puts the slot on the free list
+         */
+        void erase(uint32_t index)
+        {
+            slot(index)->~V();
+            free_slots.push_back(index);
+        }
+
+        V& operator[](uint32_t index) { return *slot(index); };
+        const V& operator[](uint32_t index) const { return *slot(index); };
+
+        /**
+         * @brief frees all chunks. Values still alive are NOT destroyed, erase them first.
+         */
+        void release() noexcept
+        {
+            storage_alloc alloc;
+            for (auto chunk : chunks) {
+                std::allocator_traits<storage_alloc>::deallocate(alloc, chunk, chunk_size);
+            }
+            chunks.clear();
+            free_slots.clear();
+            used = 0;
+        }
+
+        void swap(value_slab& other) noexcept
+        {
+            std::swap(chunks, other.chunks);
+            std::swap(free_slots, other.free_slots);
+            std::swap(used, other.used);
+        }
+    };
+
+    /**
+     * @brief what LP3Split stores in its key colony: the key and the index of its value in the value_slab
+     */
+    template <typename K>
+    struct Key_node {
+        Key_node(const K& key_, uint32_t value_) : key{key_}, value{value_} {};
+        Key_node(K&& key_, uint32_t value_) : key{std::move(key_)}, value{value_} {};
+        const K key;
+        uint32_t value;
+    };
+}  // namespace LP
+
+/**
+ * @brief Linear probing map that keeps keys and values apart
+ * @tparam K Key
+ * @tparam V Value
+ * @tparam Hash Hashing function that should be used to hash keys
+ * @tparam Pred equality function to check if keys are equal
+ * @tparam Allocator=std::allocator the allocator
+ *
+ * @details
+ * Same probing and hashing as LP3, but the nodes in the colony only hold the key and a 32 bit index into
+ * a value_slab. When V is big (like Big from the benchmarks, 204 bytes), LP3's nodes are big too, so every key
+ * comparison in prober() pulls in cache lines that are mostly value bytes. Here the key colony stays dense,
+ * and the value is only touched once the key matched.
+ *
+ * The price is that there's no std::pair<const K, V> in memory anymore.
+ * Dereferencing an iterator gives you a std::pair<const K&, V&> by value, and it-> returns a proxy holding one.
+ * So it->second = x and (*it).first work, but taking the address of *it doesn't give you a node.
+ * References to keys and values are stable, just like LP3.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Pred = std::equal_to<K>,
+          class Allocator = std::allocator<std::pair<const K, V>>>
+class LP3Split {
+    using Node = LP::Key_node<K>;
+    using Node_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using Value_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<V>;
+    using Bucket = LP::Bucket_wrapper<Node, Node_alloc>;
+    using Pair_elem = std::pair<const K, V>;
+    using plf_iter = typename plf::colony<Node, Node_alloc>::iterator;
+    using plf_constiter = typename plf::colony<Node, Node_alloc>::const_iterator;
+
+  private:
+    Hash user_hash;
+    Pred is_equal;
+    int inserted_n;
+    int deleted_n;                             // tombstones in hash_store
+    uint64_t modulo_help;                      // faster modulo trick thing, see lemire's fastmod
+    float lf_max;                              // max loadfactor
+    std::vector<Bucket> hash_store;            // stores <hash, key node iterator>
+    const LP::tabulation_table* random_state;  // tables used for hashing, LP::default_tabulation()
+    plf::colony<Node, Node_alloc> key_store;
+    LP::value_slab<V, Value_alloc> value_store;
+
+    template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool> = true>
+    int32_t hasher(Integral key) const;  // hashes key for integral type
+    template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool> = true>
+    int32_t hasher(const NonIntegral& key) const;  // hashes key for non integral type
+    size_t prober(const K& key, const int32_t& hash) const;
+    LP::Result contains_key(const K& key) const;  // prober() with extended info
+    void rehash(size_t size);
+    void rehash_if_needed();  // grows/cleans up before an insert would overflow lf_max
+    template <class Key, class... Args>
+    plf_iter store(const LP::Result& pos_info, Key&& key, Args&&... args);  // insert node at probed position
+
+  public:
+    struct ConstIterator;
+    struct Iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const K, V>;
+        using reference = std::pair<const K&, V&>;
+        /**
+         * @brief it-> needs something to point at, so this holds the pair of references
+         */
+        struct pointer {
+            reference ref;
+            reference* operator->() { return &ref; }
+        };
+
+        plf_iter slave;
+        LP::value_slab<V, Value_alloc>* values;
+
+      public:
+        Iterator(plf_iter plf, LP::value_slab<V, Value_alloc>* values_) : slave{plf}, values{values_} {};
+        reference operator*() const { return {slave->key, (*values)[slave->value]}; }
+        pointer operator->() const { return pointer{**this}; }
+        Iterator& operator++()
+        {
+            slave++;
+            return *this;
+        };
+        Iterator operator++(int)
+        {
+            Iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        Iterator& operator--()
+        {
+            slave--;
+            return *this;
+        };
+        Iterator operator--(int)
+        {
+            Iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.slave == b.slave; };
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.slave != b.slave; };
+        friend class ConstIterator;
+    };
+
+    struct ConstIterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<const K, V>;
+        using reference = std::pair<const K&, const V&>;
+        struct pointer {
+            reference ref;
+            const reference* operator->() const { return &ref; }
+        };
+
+        plf_iter slave;
+        const LP::value_slab<V, Value_alloc>* values;
+
+      public:
+        ConstIterator(plf_iter plf, const LP::value_slab<V, Value_alloc>* values_) : slave{plf}, values{values_} {};
+        ConstIterator(Iterator lp3_it) : slave{lp3_it.slave}, values{lp3_it.values} {};
+        reference operator*() const { return {slave->key, (*values)[slave->value]}; }
+        pointer operator->() const { return pointer{**this}; }
+        ConstIterator& operator++()
+        {
+            slave++;
+            return *this;
+        };
+        ConstIterator operator++(int)
+        {
+            ConstIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        ConstIterator& operator--()
+        {
+            slave--;
+            return *this;
+        };
+        ConstIterator operator--(int)
+        {
+            ConstIterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        friend bool operator==(const ConstIterator& a, const ConstIterator& b) { return a.slave == b.slave; };
+        friend bool operator!=(const ConstIterator& a, const ConstIterator& b) { return a.slave != b.slave; };
+    };
+
+    Iterator begin() { return Iterator(key_store.begin(), &value_store); };
+    Iterator end() { return Iterator(key_store.end(), &value_store); };
+    ConstIterator cbegin() const { return ConstIterator(mutable_keys().begin(), &value_store); };
+    ConstIterator cend() const { return ConstIterator(mutable_keys().end(), &value_store); };
+
+    using value_type = Pair_elem;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using difference_type = typename iterator::difference_type;
+    using size_type = difference_type;
+
+    // constructors and destructors
+    LP3Split() : LP3Split(size_t(251)){};
+    explicit LP3Split(size_t size, const Hash& hash = Hash(), const Pred& equal = Pred());
+    LP3Split(const LP3Split& other);
+    LP3Split(LP3Split&& other) noexcept;
+    LP3Split(std::initializer_list<Pair_elem> init);
+    ~LP3Split() { clear(); };
+    LP3Split& operator=(const LP3Split& other);
+    LP3Split& operator=(LP3Split&& other) noexcept;
+
+    bool empty() const noexcept { return key_store.empty(); };
+    int32_t size() const { return inserted_n; };
+
+    // modifiers
+    void clear() noexcept;
+    std::pair<Iterator, bool> insert(const Pair_elem& kv);
+    std::pair<Iterator, bool> insert(Pair_elem&& kv);
+    template <class M>
+    std::pair<Iterator, bool> insert_or_assign(const K& k, M&& obj);
+    template <class... Args>
+    std::pair<Iterator, bool> try_emplace(const K& k, Args&&... args);
+    void swap(LP3Split& other) noexcept;
+    size_t erase(const K& key);
+    Iterator erase(ConstIterator it);
+    Iterator erase(Iterator it) { return erase(ConstIterator{it}); };
+
+    // lookups
+    V& operator[](const K& k);
+    V& at(const K& k);
+    const V& at(const K& k) const;
+    size_t count(const K& key) const { return contains_key(key).contains; };
+    bool contains(const K& key) const { return contains_key(key).contains; };
+    Iterator find(const K& key);
+    ConstIterator find(const K& key) const;
+
+    // bucket interface and hash policy
+    size_t bucket_count() const { return hash_store.size(); };
+    float load_factor() const { return key_store.size() / (float)hash_store.size(); };
+    float max_load_factor() const { return lf_max; };
+    void max_load_factor(float ml);
+    void rehash();
+    void reserve(int size);
+
+  private:
+    // the const iterators wrap the non const plf iterator, same as LP3
+    plf::colony<Node, Node_alloc>& mutable_keys() const { return const_cast<plf::colony<Node, Node_alloc>&>(key_store); }
+};
+
+#ifndef LP3SPLIT_DEF_H
+
+/**
+ * @brief hashes non integral keys. the user's hash, then tabulation hashing over all 8 bytes of it like LP3
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename NonIntegral, LP::enable_if_t<!std::is_integral<NonIntegral>{}, bool>>
+int32_t LP3Split<K, V, Hash, Pred, Allocator>::hasher(const NonIntegral& key) const
+{
+    return LP::tabulate(static_cast<uint64_t>(user_hash(key)), *random_state);
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <typename Integral, LP::enable_if_t<std::is_integral<Integral>{}, bool>>
+int32_t LP3Split<K, V, Hash, Pred, Allocator>::hasher(Integral key) const
+{
+    int32_t hash = key;
+    return (hash == LP::DELETED || hash == LP::EMPTY) ? ~hash : hash;
+}
+
+/**
+ * @return the position where key is located or should be inserted to
+ * @details
+ * Only the hash array and the key colony get touched here, never the values.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Split<K, V, Hash, Pred, Allocator>::prober(const K& key, const int32_t& hash) const
+{
+    int32_t size = hash_store.size();
+    int32_t pos = fastmod::fastmod_s32(hash, modulo_help, size);
+    pos = (pos < 0) ? ~pos : pos;
+    for (int i = 0; i < size; i++) {
+        if (hash_store[pos].hash != LP::EMPTY
+            && (hash_store[pos].hash != hash || not is_equal(hash_store[pos].pair_iter->key, key))) {
+            pos++;
+            if (pos >= size) {
+                pos -= size;
+            }
+        }
+        else {
+            return pos;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @return Result{exists, position, hash}
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP::Result LP3Split<K, V, Hash, Pred, Allocator>::contains_key(const K& key) const
+{
+    int32_t hash = hasher(key);
+    int pos = prober(key, hash);
+    return {hash_store[pos].hash != LP::EMPTY, pos, hash};
+}
+
+/**
+ * @brief constructs the value in the slab and the key node in the colony, and fills the probed bucket
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class Key, class... Args>
+typename LP3Split<K, V, Hash, Pred, Allocator>::plf_iter LP3Split<K, V, Hash, Pred, Allocator>::store(
+    const LP::Result& pos_info, Key&& key, Args&&... args)
+{
+    uint32_t value = value_store.emplace(std::forward<Args>(args)...);
+    auto it = key_store.emplace(std::forward<Key>(key), value);
+    hash_store[pos_info.pos] = Bucket{pos_info.hash, it};
+    inserted_n++;
+    return it;
+}
+
+/**
+ * @brief constructor where you specify size
+ * @param size How many objects can be stored without rehash.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Split<K, V, Hash, Pred, Allocator>::LP3Split(size_t size, const Hash& hash, const Pred& equal)
+    : user_hash(hash),
+      is_equal(equal),
+      inserted_n{0},
+      deleted_n{0},
+      modulo_help(fastmod::computeM_s32(LP::next_prime(2 * size))),
+      lf_max{0.5},
+      hash_store(LP::next_prime(2 * size)),
+      random_state{&LP::default_tabulation()},
+      key_store{},
+      value_store{}
+{
+}
+
+/**
+ * @details Copy constructor. the values have to be copied one by one since the slab can't be copied
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Split<K, V, Hash, Pred, Allocator>::LP3Split(const LP3Split& other) : LP3Split(size_t(other.size()))
+{
+    lf_max = other.lf_max;
+    for (auto it = other.cbegin(); it != other.cend(); it++) {
+        insert({it->first, it->second});
+    }
+}
+
+/**
+ * @details Move constructor
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Split<K, V, Hash, Pred, Allocator>::LP3Split(LP3Split&& other) noexcept : LP3Split(size_t(0))
+{
+    swap(other);
+}
+
+/**
+ * @brief constructor from initializer list
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Split<K, V, Hash, Pred, Allocator>::LP3Split(std::initializer_list<Pair_elem> init) : LP3Split(init.size())
+{
+    for (const auto& x : init) {
+        insert(x);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Split<K, V, Hash, Pred, Allocator>& LP3Split<K, V, Hash, Pred, Allocator>::operator=(const LP3Split& other)
+{
+    LP3Split temp{other};
+    swap(temp);
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+LP3Split<K, V, Hash, Pred, Allocator>& LP3Split<K, V, Hash, Pred, Allocator>::operator=(LP3Split&& other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+/**
+ * @brief deletes all keys and values, so size is 0. Keeps the bucket count.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Split<K, V, Hash, Pred, Allocator>::clear() noexcept
+{
+    for (auto& node : key_store) {
+        value_store.erase(node.value);
+    }
+    value_store.release();
+    key_store.clear();
+    std::fill(hash_store.begin(), hash_store.end(), Bucket{});
+    inserted_n = 0;
+    deleted_n = 0;
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map
+ * @return pair<iterator to map[k], bool is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+std::pair<typename LP3Split<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3Split<K, V, Hash, Pred, Allocator>::insert(
+    const Pair_elem& kv)
+{
+    rehash_if_needed();
+    auto pos_info = contains_key(kv.first);
+    if (pos_info.contains) {
+        return {Iterator(hash_store[pos_info.pos].pair_iter.convert(), &value_store), false};
+    }
+    return {Iterator(store(pos_info, kv.first, kv.second), &value_store), true};
+}
+
+/**
+ * @brief inserts kv if kv.first doesn't exist in map, moving the value
+ * @return pair<iterator to map[k], bool is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+std::pair<typename LP3Split<K, V, Hash, Pred, Allocator>::Iterator, bool> LP3Split<K, V, Hash, Pred, Allocator>::insert(
+    Pair_elem&& kv)
+{
+    rehash_if_needed();
+    auto pos_info = contains_key(kv.first);
+    if (pos_info.contains) {
+        return {Iterator(hash_store[pos_info.pos].pair_iter.convert(), &value_store), false};
+    }
+    return {Iterator(store(pos_info, kv.first, std::move(kv.second)), &value_store), true};
+}
+
+/**
+ * @details assigns obj to map[k] if k exists, inserts (k, obj) otherwise
+ * @return pair<iterator, is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class M>
+std::pair<typename LP3Split<K, V, Hash, Pred, Allocator>::Iterator, bool>
+LP3Split<K, V, Hash, Pred, Allocator>::insert_or_assign(const K& k, M&& obj)
+{
+    rehash_if_needed();
+    auto pos_info = contains_key(k);
+    if (pos_info.contains) {
+        auto it = hash_store[pos_info.pos].pair_iter;
+        value_store[it->value] = std::forward<M>(obj);
+        return {Iterator(it.convert(), &value_store), false};
+    }
+    return {Iterator(store(pos_info, k, std::forward<M>(obj)), &value_store), true};
+}
+
+/**
+ * @details constructs V from args in place if k doesn't exist. Does nothing otherwise.
+ * @return pair<iterator, is inserted>
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+template <class... Args>
+std::pair<typename LP3Split<K, V, Hash, Pred, Allocator>::Iterator, bool>
+LP3Split<K, V, Hash, Pred, Allocator>::try_emplace(const K& k, Args&&... args)
+{
+    rehash_if_needed();
+    auto pos_info = contains_key(k);
+    if (pos_info.contains) {
+        return {Iterator(hash_store[pos_info.pos].pair_iter.convert(), &value_store), false};
+    }
+    return {Iterator(store(pos_info, k, std::forward<Args>(args)...), &value_store), true};
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Split<K, V, Hash, Pred, Allocator>::swap(LP3Split& other) noexcept
+{
+    std::swap(user_hash, other.user_hash);
+    std::swap(is_equal, other.is_equal);
+    std::swap(inserted_n, other.inserted_n);
+    std::swap(deleted_n, other.deleted_n);
+    std::swap(modulo_help, other.modulo_help);
+    std::swap(lf_max, other.lf_max);
+    std::swap(hash_store, other.hash_store);
+    std::swap(random_state, other.random_state);
+    std::swap(key_store, other.key_store);
+    value_store.swap(other.value_store);
+}
+
+/**
+ * @brief erase element with key
+ * @return number of erased elements
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+size_t LP3Split<K, V, Hash, Pred, Allocator>::erase(const K& key)
+{
+    auto pos_info = contains_key(key);
+    if (not pos_info.contains) {
+        return 0;
+    }
+    auto& bucket = hash_store[pos_info.pos];
+    bucket.hash = LP::DELETED;
+    value_store.erase(bucket.pair_iter->value);
+    key_store.erase(bucket.pair_iter.convert());
+    inserted_n--;
+    deleted_n++;
+    return 1;
+}
+
+/**
+ * @param it iterator to element that will be deleted
+ * @return iterator to the element after it
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename LP3Split<K, V, Hash, Pred, Allocator>::Iterator LP3Split<K, V, Hash, Pred, Allocator>::erase(ConstIterator it)
+{
+    if (it.slave == key_store.end()) {
+        return end();
+    }
+    auto pos_info = contains_key(it.slave->key);
+    hash_store[pos_info.pos].hash = LP::DELETED;
+    value_store.erase(it.slave->value);
+    inserted_n--;
+    deleted_n++;
+    return Iterator(key_store.erase(it.slave), &value_store);
+}
+
+/**
+ * @brief access operator, also inserts <key, V{}> if key doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V& LP3Split<K, V, Hash, Pred, Allocator>::operator[](const K& k)
+{
+    return try_emplace(k).first->second;
+}
+
+/**
+ * @throws std::out_of_range if k doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+V& LP3Split<K, V, Hash, Pred, Allocator>::at(const K& k)
+{
+    auto pos_info = contains_key(k);
+    if (pos_info.contains) {
+        return value_store[hash_store[pos_info.pos].pair_iter->value];
+    }
+    throw std::out_of_range("key doesn't exist");
+}
+
+/**
+ * @throws std::out_of_range if k doesn't exist
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+const V& LP3Split<K, V, Hash, Pred, Allocator>::at(const K& k) const
+{
+    auto pos_info = contains_key(k);
+    if (pos_info.contains) {
+        return value_store[hash_store[pos_info.pos].pair_iter->value];
+    }
+    throw std::out_of_range("key doesn't exist");
+}
+
+/**
+ * @return iterator to key if exists, end() if it doesn't
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename LP3Split<K, V, Hash, Pred, Allocator>::Iterator LP3Split<K, V, Hash, Pred, Allocator>::find(const K& key)
+{
+    auto pos_info = contains_key(key);
+    if (pos_info.contains) {
+        return Iterator(hash_store[pos_info.pos].pair_iter.convert(), &value_store);
+    }
+    return end();
+}
+
+/**
+ * @return const iterator to key if exists, cend() if it doesn't
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+typename LP3Split<K, V, Hash, Pred, Allocator>::ConstIterator LP3Split<K, V, Hash, Pred, Allocator>::find(
+    const K& key) const
+{
+    auto pos_info = contains_key(key);
+    if (pos_info.contains) {
+        return ConstIterator(hash_store[pos_info.pos].pair_iter.convert(), &value_store);
+    }
+    return cend();
+}
+
+/**
+ * @throws std::out_of_range if ml > 1
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Split<K, V, Hash, Pred, Allocator>::max_load_factor(float ml)
+{
+    if (ml > 1) {
+        throw std::out_of_range("max loadfactor is 1");
+    }
+    lf_max = ml;
+    if (key_store.size() / (float)hash_store.size() > ml) {
+        rehash(LP::next_prime(inserted_n / ml));
+    }
+}
+
+/**
+ * @brief rehash into a new bucket array of size buckets. The key and value stores don't move.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Split<K, V, Hash, Pred, Allocator>::rehash(size_t size)
+{
+    std::vector<Bucket> arr_new(size);
+    uint64_t helper = fastmod::computeM_s32(size);
+    for (const auto& x : hash_store) {
+        if (x.hash == LP::EMPTY || x.hash == LP::DELETED) {
+            continue;
+        }
+        int32_t home = fastmod::fastmod_s32(x.hash, helper, size);
+        size_t loc = (home < 0) ? ~home : home;
+        while (arr_new[loc].hash != LP::EMPTY) {
+            loc++;
+            if (loc >= size) {
+                loc -= size;
+            }
+        }
+        arr_new[loc] = x;
+    }
+    hash_store = std::move(arr_new);
+    modulo_help = helper;
+    deleted_n = 0;
+}
+
+/**
+ * @details
+ * Tombstones count towards the load like LP3's: prober() doesn't stop at them, so a table that fills up with
+ * them has no EMPTY bucket left to end a probe. Rehashing drops them.
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+inline void LP3Split<K, V, Hash, Pred, Allocator>::rehash_if_needed()
+{
+    if (((inserted_n + deleted_n + 1) / (float)hash_store.size()) > lf_max) {
+        // room for the element being inserted too, or a full table gets rehashed to the size it has
+        [[unlikely]] rehash(LP::next_prime(int((key_store.size() + 1) / lf_max)));
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Split<K, V, Hash, Pred, Allocator>::rehash()
+{
+    rehash(LP::next_prime(int(key_store.size() / lf_max)));
+}
+
+/**
+ * @brief make room for size elements without rehashing
+ */
+template <typename K, typename V, typename Hash, typename Pred, class Allocator>
+void LP3Split<K, V, Hash, Pred, Allocator>::reserve(int size)
+{
+    size_t s = LP::next_prime(size_t(1 + size / lf_max));
+    if (s <= hash_store.size()) {
+        return;
+    }
+    rehash(s);
+}
+
+/**
+ * @return true if both maps have the same keys, mapped to equal values
+ */
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
+bool operator==(const LP3Split<K_, V_, Hash_, Pred_, Allocator_>& lhs,
+                const LP3Split<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+{
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (auto it = lhs.cbegin(); it != lhs.cend(); it++) {
+        auto rhs_it = rhs.find(it->first);
+        if (rhs_it == rhs.cend() || !(rhs_it->second == it->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class K_, class V_, class Hash_, class Pred_, class Allocator_>
+bool operator!=(const LP3Split<K_, V_, Hash_, Pred_, Allocator_>& lhs,
+                const LP3Split<K_, V_, Hash_, Pred_, Allocator_>& rhs)
+{
+    return not(lhs == rhs);
+}
+
+#endif  // LP3SPLIT_DEF_H
+#endif  // LPSPLIT_H
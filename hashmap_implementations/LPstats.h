@@ -0,0 +1,206 @@
+#ifndef LPSTATS_H
+#define LPSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace LP {
+
+    /*
+     * Instrumentation policies for LP3, its Stats template parameter.
+     * LP3 calls these static hooks from prober(), the inserts, the erases and rehash():
+     * - lookup(probes): prober() looked at probes buckets. every lookup, insert and erase by key walks 1 probe sequence
+     * - key_mismatch(): a bucket had the same hash as the key, but another key
+     * - rehash(nanoseconds, tombstones): a rehash took that long and dropped that many tombstones.
+     *   LP3's inserts never reuse tombstones, a rehash is where they go away
+     * - tombstone_created(): an erase left a tombstone
+     * - colony_allocation(): an insert made the colony allocate a new group
+     * enabled tells LP3 whether to do the work that only the hooks need, like reading the clock.
+     */
+
+    /**
+     * @brief the default: every hook is empty, so LP3 compiles to the same code as without any hooks
+     */
+    struct no_stats {
+        static constexpr bool enabled = false;
+        static void lookup(size_t) {}
+        static void key_mismatch() {}
+        static void rehash(uint64_t, size_t) {}
+        static void tombstone_created() {}
+        static void colony_allocation() {}
+    };
+
+    /**
+     * @brief the totals of a counting_stats policy
+     */
+    struct Stats_counters {
+        uint64_t lookups;
+        uint64_t probes;  // buckets looked at by all lookups together
+        uint64_t key_mismatches;
+        uint64_t rehashes;
+        uint64_t rehash_nanoseconds;
+        uint64_t tombstones_created;
+        uint64_t tombstones_purged;  // dropped by rehashes
+        uint64_t colony_allocations;
+
+        double mean_probes() const { return lookups ? probes / static_cast<double>(lookups) : 0; }
+    };
+
+    /**
+     * @brief the counters in the Prometheus text format, names starting with prefix
+     */
+    inline std::string to_prometheus(const Stats_counters& counters, const std::string& prefix = "lp3")
+    {
+        std::string text;
+        auto add = [&](const char* name, const char* help, const std::string& value) {
+            const std::string metric = prefix + "_" + name;
+            text += "# HELP " + metric + " " + help + "\n";
+            text += "# TYPE " + metric + " counter\n";
+            text += metric + " " + value + "\n";
+        };
+        add("lookups_total", "Probe sequences walked.", std::to_string(counters.lookups));
+        add("probes_total", "Buckets looked at by all probe sequences.", std::to_string(counters.probes));
+        add("key_mismatches_total", "Buckets with the hash of the key that held another key.",
+            std::to_string(counters.key_mismatches));
+        add("rehashes_total", "Rehashes, growing, shrinking or cleaning up.", std::to_string(counters.rehashes));
+        add("rehash_seconds_total", "Time spent rehashing.", std::to_string(counters.rehash_nanoseconds / 1e9));
+        add("tombstones_created_total", "Buckets erase() left a tombstone in.",
+            std::to_string(counters.tombstones_created));
+        add("tombstones_purged_total", "Tombstones dropped by rehashes.", std::to_string(counters.tombstones_purged));
+        add("colony_allocations_total", "Element groups allocated by inserts.",
+            std::to_string(counters.colony_allocations));
+        return text;
+    }
+
+    /**
+     * @brief counts every hook, in counters per thread
+     * @tparam Tag maps with the same Tag share their counters, give maps their own Tag to count them apart
+     * @details
+     * A thread only writes its own counters, with plain relaxed loads and stores, so the hooks cost an increment
+     * and never bounce a cache line between threads. snapshot() adds up the counters of all threads, and of the
+     * threads that are gone. It's exact once the threads it counts are done, and close while they're running.
+     */
+    template <class Tag = void>
+    class counting_stats {
+        enum Counter { lookups, probes, key_mismatches, rehashes, rehash_ns, created, purged, allocations, count };
+
+        struct Counters {
+            std::atomic<uint64_t> values[count] = {};
+        };
+        struct Registry {
+            std::mutex lock;
+            std::vector<Counters*> threads;
+            uint64_t finished[count] = {};  // counts of the threads that exited
+        };
+        static Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+        // registers itself on the first hook a thread calls, and leaves its counts behind when the thread exits
+        struct Thread_counters {
+            Counters counters;
+            Thread_counters()
+            {
+                Registry& all = registry();
+                std::lock_guard<std::mutex> guard(all.lock);
+                all.threads.push_back(&counters);
+            }
+            ~Thread_counters()
+            {
+                Registry& all = registry();
+                std::lock_guard<std::mutex> guard(all.lock);
+                for (int c = 0; c < count; c++) {
+                    all.finished[c] += counters.values[c].load(std::memory_order_relaxed);
+                }
+                for (auto& registered : all.threads) {
+                    if (registered == &counters) {
+                        registered = all.threads.back();
+                        all.threads.pop_back();
+                        break;
+                    }
+                }
+            }
+        };
+        static void add(Counter counter, uint64_t n)
+        {
+            thread_local Thread_counters mine;
+            auto& value = mine.counters.values[counter];
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+      public:
+        static constexpr bool enabled = true;
+        static void lookup(size_t probe_n)
+        {
+            add(lookups, 1);
+            add(probes, probe_n);
+        }
+        static void key_mismatch() { add(key_mismatches, 1); }
+        static void rehash(uint64_t nanoseconds, size_t tombstones)
+        {
+            add(rehashes, 1);
+            add(rehash_ns, nanoseconds);
+            add(purged, tombstones);
+        }
+        static void tombstone_created() { add(created, 1); }
+        static void colony_allocation() { add(allocations, 1); }
+
+        static Stats_counters snapshot()
+        {
+            uint64_t totals[count];
+            Registry& all = registry();
+            {
+                std::lock_guard<std::mutex> guard(all.lock);
+                for (int c = 0; c < count; c++) {
+                    totals[c] = all.finished[c];
+                    for (auto thread : all.threads) {
+                        totals[c] += thread->values[c].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            return {totals[lookups],   totals[probes],  totals[key_mismatches], totals[rehashes],
+                    totals[rehash_ns], totals[created], totals[purged],         totals[allocations]};
+        }
+        // zero, for a test or a new measurement window. Increments racing with it may survive it
+        static void reset()
+        {
+            Registry& all = registry();
+            std::lock_guard<std::mutex> guard(all.lock);
+            for (int c = 0; c < count; c++) {
+                all.finished[c] = 0;
+                for (auto thread : all.threads) {
+                    thread->values[c].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief the time since it was made, in nanoseconds, for rehash(). doesn't read the clock unless Stats::enabled
+     */
+    template <class Stats>
+    class stats_timer {
+        std::chrono::steady_clock::time_point start;
+
+      public:
+        stats_timer() : start{Stats::enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}}
+        {
+        }
+        uint64_t nanoseconds() const
+        {
+            if (!Stats::enabled) {
+                return 0;
+            }
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                .count();
+        }
+    };
+
+}  // namespace LP
+
+#endif  // LPSTATS_H
@@ -0,0 +1,202 @@
+#ifndef LPSTRING_H
+#define LPSTRING_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#ifdef __AVX2__
+#    include <immintrin.h>
+#endif
+
+namespace LP {
+
+    /*
+     * Hashing and comparing string keys, the defaults of LP3<std::string, V> and LP3<std::string_view, V> (see
+     * default_hash and default_equal).
+     * Both take std::string_view, so they work for anything that converts to one.
+     *
+     * LP3 doesn't keep a fingerprint of the key in its buckets: hash_store already holds 31 bits of the hash and
+     * prober() only compares keys when those match, so string_equal nearly always sees the key that's being looked
+     * for. Its length and prefix checks are for the rest: keys whose user hashes collide.
+     */
+
+    inline uint64_t read64(const char* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t read32(const char* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // the 128 bit product of a and b, folded to 64 bits. What every step of wyhash is built on
+    inline uint64_t fold_multiply(uint64_t a, uint64_t b)
+    {
+#ifdef __SIZEOF_INT128__
+        const __uint128_t product = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+        const uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32, b_lo = b & 0xffffffff, b_hi = b >> 32;
+        const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+        const uint64_t middle = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+        const uint64_t low = (middle << 32) | (lo_lo & 0xffffffff);
+        const uint64_t high = hi_hi + (hi_lo >> 32) + (middle >> 32);
+        return low ^ high;
+#endif
+    }
+
+    /**
+     * @brief wyhash (Wang Yi, public domain), the version that reads 48 bytes per round
+     * @details
+     * Keys up to 16 bytes are 2 overlapping reads and 2 multiplies, without a loop. Longer keys go 16 bytes at a
+     * time, or 48 in 3 independent lanes, so the multiplies of a round don't wait on each other. That keeps up with
+     * an AVX2 hash for keys up to a few hundred bytes, and needs no setup for the short ones.
+     */
+    inline uint64_t wyhash(const char* p, size_t len, uint64_t seed = 0)
+    {
+        constexpr uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull,
+                                        0x4d5a2da51de1aa47ull};
+        seed ^= fold_multiply(seed ^ secret[0], secret[1]);
+        uint64_t a;
+        uint64_t b;
+        if (len <= 16) {
+            if (len >= 4) {
+                const size_t middle = (len >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + middle);
+                b = (read32(p + len - 4) << 32) | read32(p + len - 4 - middle);
+            }
+            else if (len > 0) {
+                const auto byte = [&](size_t i) { return static_cast<uint64_t>(static_cast<unsigned char>(p[i])); };
+                a = (byte(0) << 16) | (byte(len >> 1) << 8) | byte(len - 1);
+                b = 0;
+            }
+            else {
+                a = b = 0;
+            }
+        }
+        else {
+            size_t left = len;
+            if (left > 48) {
+                uint64_t lane1 = seed;
+                uint64_t lane2 = seed;
+                do {
+                    seed = fold_multiply(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                    lane1 = fold_multiply(read64(p + 16) ^ secret[2], read64(p + 24) ^ lane1);
+                    lane2 = fold_multiply(read64(p + 32) ^ secret[3], read64(p + 40) ^ lane2);
+                    p += 48;
+                    left -= 48;
+                } while (left > 48);
+                seed ^= lane1 ^ lane2;
+            }
+            while (left > 16) {
+                seed = fold_multiply(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                p += 16;
+                left -= 16;
+            }
+            a = read64(p + left - 16);
+            b = read64(p + left - 8);
+        }
+        a ^= secret[1];
+        b ^= seed;
+#ifdef __SIZEOF_INT128__
+        const __uint128_t product = static_cast<__uint128_t>(a) * b;
+        a = static_cast<uint64_t>(product);
+        b = static_cast<uint64_t>(product >> 64);
+#else
+        const uint64_t folded = fold_multiply(a, b);
+        a *= b;
+        b = folded ^ a;
+#endif
+        return fold_multiply(a ^ secret[0] ^ len, b ^ secret[1]);
+    }
+
+    /**
+     * @brief whether the n bytes at a and b are the same
+     * @details
+     * The first 8 bytes go first, since keys that differ mostly differ early on. Up to 32 bytes it's 2 overlapping
+     * reads from each end, inlined. Longer keys go to memcmp: glibc's is vectorized already, and an inlined AVX2
+     * loop measured slower than it at 128 and 256 bytes.
+     */
+    inline bool same_bytes(const char* a, const char* b, size_t n)
+    {
+        if (n < 8) {
+            if (n >= 4) {
+                return read32(a) == read32(b) && read32(a + n - 4) == read32(b + n - 4);
+            }
+            return std::memcmp(a, b, n) == 0;
+        }
+        if (read64(a) != read64(b)) {
+            return false;
+        }
+        if (n <= 16) {
+            return read64(a + n - 8) == read64(b + n - 8);
+        }
+#ifdef __AVX2__
+        if (n <= 32) {
+            const auto block = [](const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+            const __m128i same = _mm_and_si128(_mm_cmpeq_epi8(block(a), block(b)),
+                                               _mm_cmpeq_epi8(block(a + n - 16), block(b + n - 16)));
+            return _mm_movemask_epi8(same) == 0xffff;
+        }
+#endif
+        return std::memcmp(a + 8, b + 8, n - 8) == 0;
+    }
+
+    /**
+     * @brief hash function for string keys, wyhash over the bytes
+     */
+    struct string_hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return wyhash(key.data(), key.size()); }
+    };
+
+    /**
+     * @brief equality for string keys: the lengths, then same_bytes()
+     */
+    struct string_equal {
+        using is_transparent = void;
+        bool operator()(std::string_view a, std::string_view b) const
+        {
+            return a.size() == b.size() && same_bytes(a.data(), b.data(), a.size());
+        }
+    };
+
+    /**
+     * @brief what LP3 hashes and compares K with when it isn't told: std::hash and std::equal_to, except for strings
+     */
+    template <class K>
+    struct default_hash {
+        using type = std::hash<K>;
+    };
+    template <>
+    struct default_hash<std::string> {
+        using type = string_hash;
+    };
+    template <>
+    struct default_hash<std::string_view> {
+        using type = string_hash;
+    };
+
+    template <class K>
+    struct default_equal {
+        using type = std::equal_to<K>;
+    };
+    template <>
+    struct default_equal<std::string> {
+        using type = string_equal;
+    };
+    template <>
+    struct default_equal<std::string_view> {
+        using type = string_equal;
+    };
+
+}  // namespace LP
+
+#endif  // LPSTRING_H
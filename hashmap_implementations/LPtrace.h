@@ -0,0 +1,152 @@
+#ifndef LPTRACE_H
+#define LPTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace LP {
+
+    /*
+     * Resize tracing for LP3. A map calls its on_resize() hook when a rehash starts and when it ends, on the thread
+     * doing the rehash. Built with LP3_USDT defined, LP3 also has the static probe points lp3:resize_start and
+     * lp3:resize_end (sys/sdt.h from systemtap), for perf/bpftrace/SystemTap on builds without a hook set.
+     */
+
+    // what made the map rehash
+    enum class Resize_cause : uint8_t {
+        insert,
+        erase,
+        reserve,
+        rehash,
+        max_load_factor,
+        shrink_to_fit,
+        purge_tombstones,
+        reseed  // an insert probed too far, see LP3::flood_threshold()
+    };
+
+    inline const char* to_string(Resize_cause cause)
+    {
+        switch (cause) {
+            case Resize_cause::insert: return "insert";
+            case Resize_cause::erase: return "erase";
+            case Resize_cause::reserve: return "reserve";
+            case Resize_cause::rehash: return "rehash";
+            case Resize_cause::max_load_factor: return "max_load_factor";
+            case Resize_cause::shrink_to_fit: return "shrink_to_fit";
+            case Resize_cause::purge_tombstones: return "purge_tombstones";
+            case Resize_cause::reseed: return "reseed";
+        }
+        return "unknown";
+    }
+
+    // steady_clock in nanoseconds, what Resize_event::timestamp is in
+    inline uint64_t trace_clock()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 1 end of a rehash
+     * @details live and tombstones are the counts at that moment, so tombstones is 0 at the end of every rehash
+     */
+    struct Resize_event {
+        enum class Phase : uint8_t { start, end };
+        uint64_t timestamp;    // trace_clock()
+        uint64_t nanoseconds;  // how long the rehash took, 0 at the start
+        uint64_t old_buckets;
+        uint64_t new_buckets;
+        uint64_t live;
+        uint64_t tombstones;
+        Phase phase;
+        Resize_cause cause;
+        bool in_place;  // see LP3::in_place_rehash()
+    };
+
+    /**
+     * @brief the last Capacity resize events of any number of maps, without locks
+     * @details
+     * Pass it to on_resize() with std::ref, and read it from anywhere with events(). push() picks a slot with
+     * 1 fetch_add and takes it with a CAS on its sequence number, events() skips the slots that are being written.
+     * Old events get overwritten. A push whose slot is still being written by an older one waits for it, and one
+     * that finds a newer event in its slot drops its own, so 2 pushes never write the same slot at once.
+     */
+    template <size_t Capacity = 256>
+    class resize_ring {
+        static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of 2");
+        static_assert(std::is_trivially_copyable<Resize_event>::value, "events are copied as words");
+        static constexpr size_t words = (sizeof(Resize_event) + 7) / 8;
+
+        struct Slot {
+            std::atomic<uint64_t> sequence{0};  // 2n + 2 once event n is in, odd while it's being written
+            std::atomic<uint64_t> data[words];
+        };
+        std::atomic<uint64_t> head{0};
+        Slot slots[Capacity];
+
+      public:
+        void push(const Resize_event& event)
+        {
+            const uint64_t n = head.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots[n & (Capacity - 1)];
+            uint64_t raw[words] = {};
+            std::memcpy(raw, &event, sizeof(event));
+            uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+            while (true) {
+                if (sequence > 2 * n) {
+                    return;  // a newer event has the slot already
+                }
+                if (sequence & 1) {
+                    std::this_thread::yield();  // an older push is still writing it
+                    sequence = slot.sequence.load(std::memory_order_relaxed);
+                }
+                else if (slot.sequence.compare_exchange_weak(sequence, 2 * n + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t w = 0; w < words; w++) {
+                slot.data[w].store(raw[w], std::memory_order_relaxed);
+            }
+            slot.sequence.store(2 * n + 2, std::memory_order_release);
+        }
+        void operator()(const Resize_event& event) { push(event); }
+
+        // events pushed so far, including the overwritten ones
+        uint64_t pushed() const { return head.load(std::memory_order_acquire); }
+
+        // the events still in the ring, oldest first
+        std::vector<Resize_event> events() const
+        {
+            std::vector<Resize_event> result;
+            const uint64_t end = pushed();
+            for (uint64_t n = end > Capacity ? end - Capacity : 0; n < end; n++) {
+                const Slot& slot = slots[n & (Capacity - 1)];
+                const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+                if (before != 2 * n + 2) {
+                    continue;  // still being written, or already overwritten
+                }
+                uint64_t raw[words];
+                for (size_t w = 0; w < words; w++) {
+                    raw[w] = slot.data[w].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != before) {
+                    continue;
+                }
+                Resize_event event;
+                std::memcpy(&event, raw, sizeof(event));
+                result.push_back(event);
+            }
+            return result;
+        }
+    };
+
+}  // namespace LP
+
+#endif  // LPTRACE_H
@@ -259,7 +259,7 @@
 #endif
 
 namespace LP {  // MASSIVEATOMS addition
-    template <typename K, typename V, class Allocator>
+    template <typename T, class Allocator>
     class naive_faster_colony_iter;
 
 }
@@ -343,7 +343,7 @@ namespace plf {
         friend class colony_reverse_iterator<false>;
         friend class colony_reverse_iterator<true>;
         // MASSIVEATOMS addition
-        template <typename K, typename V, class Allocator>
+        template <typename T, class Allocator>
         friend class LP::naive_faster_colony_iter;
 
       private:
@@ -553,7 +553,7 @@ namespace plf {
             skipfield_pointer_type skipfield_pointer;
 
             // MASSIVEATOMS Addition
-            template <typename K, typename V, class Allocator>
+            template <typename T, class Allocator>
             friend class LP::naive_faster_colony_iter;
 
           public:
@@ -4091,6 +4091,38 @@ namespace plf {
             return mem;
         }
 
+        // MASSIVEATOMS addition: what the groups hold, for LP3::memory_usage()
+        struct group_statistics {
+            size_type groups;           // groups with elements in them
+            size_type reserved_groups;  // empty groups kept by erase() or made by reserve()
+            size_type capacity;         // element slots in all of them
+            size_type erased;           // slots that held an element which got erased, reused by the next inserts
+            size_type skipfield_bytes;  // skipfields of all groups
+            size_type bytes;            // like memory(), which doesn't work on a colony without groups
+        };
+
+        group_statistics group_stats() const PLF_NOEXCEPT
+        {
+            group_statistics stats = {0, 0, 0, 0, 0, sizeof(*this)};
+            for (group_pointer_type current = begin_iterator.group_pointer; current != NULL;
+                 current = current->next_group) {
+                stats.groups++;
+                stats.capacity += current->capacity;
+                stats.erased += static_cast<size_type>(current->last_endpoint - current->elements) - current->size;
+                stats.skipfield_bytes += (current->capacity + 1u) * sizeof(skipfield_type);
+                stats.bytes += sizeof(group)
+                               + PLF_GROUP_ALIGNED_BLOCK_SIZE(current->capacity) * sizeof(aligned_allocation_struct);
+            }
+            for (group_pointer_type current = unused_groups_head; current != NULL; current = current->next_group) {
+                stats.reserved_groups++;
+                stats.capacity += current->capacity;
+                stats.skipfield_bytes += (current->capacity + 1u) * sizeof(skipfield_type);
+                stats.bytes += sizeof(group)
+                               + PLF_GROUP_ALIGNED_BLOCK_SIZE(current->capacity) * sizeof(aligned_allocation_struct);
+            }
+            return stats;
+        }
+
       private:
         // get all elements contiguous in memory and shrink to fit, remove erasures and erasure free lists. Invalidates
         // all iterators and pointers to elements.
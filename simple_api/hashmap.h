@@ -1,19 +1,43 @@
+#ifndef SIMPLE_API_HASHMAP_H
+#define SIMPLE_API_HASHMAP_H
 
 #include <initializer_list>
+#include <stdexcept>
+
+#include "./../hashmap_implementations/Cuckoo.h"
 
 class PO2_map {
+  public:
+    virtual ~PO2_map() = default;
     virtual int& operator[](const int& k) = 0;  // lookup and if you can, insert
     virtual int& operator[](int&& k) = 0;       // lookup and if you can, insert
     virtual int erase(const int& k) = 0;  // erase, duh
     virtual void reserve(int n) = 0;      // set size of the array
-    void insert(std::initializer_list<int> il); // inserts
+    virtual void insert(std::initializer_list<int> il) = 0; // inserts {key, value}
 };
 
 
+// int -> int cuckoo map behind the PO2_map interface. see CuckooMap in hashmap_implementations/Cuckoo.h
 class Cuckoo : public PO2_map {
+    CuckooMap<int, int> map;
+
+  public:
     // constructor
+    Cuckoo() = default;
     // destructor
+    ~Cuckoo() override = default;
 
+    int& operator[](const int& k) override { return map[k]; }
+    int& operator[](int&& k) override { return map[k]; }
+    int erase(const int& k) override { return map.erase(k); }
+    void reserve(int n) override { map.reserve(n); }
+    void insert(std::initializer_list<int> il) override
+    {
+        if (il.size() != 2) {
+            throw std::invalid_argument("insert takes {key, value}");
+        }
+        map.insert({*il.begin(), *(il.begin() + 1)});
+    }
 };
 
-
+#endif  // SIMPLE_API_HASHMAP_H
@@ -0,0 +1,104 @@
+//
+// Tests for LP3Arena, LP::string_arena and LP::string_interner
+//
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./../hashmap_implementations/LParena.h"
+
+TEST_CASE("string_arena hands out stable copies", "[arena]")
+{
+    LP::string_arena arena(64);
+    std::vector<std::string_view> views;
+    std::vector<std::string> originals;
+    for (int i = 0; i < 1000; i++) {
+        originals.push_back(std::string(i % 100, static_cast<char>('a' + i % 26)));
+        views.push_back(arena.append(originals.back()));
+    }
+    bool same = true;
+    for (size_t i = 0; i < views.size(); i++) {
+        same = same && views[i] == originals[i] && views[i].data() != originals[i].data();
+    }
+    REQUIRE(same);
+
+    // undo gives the bytes back to the next append, for small and for large strings
+    auto small = arena.append("12345");
+    arena.undo(small);
+    REQUIRE(arena.append("abcde").data() == small.data());
+    const size_t before = arena.bytes();
+    arena.undo(arena.append(std::string(1000, 'x')));
+    REQUIRE(arena.bytes() == before);
+
+    arena.clear();
+    REQUIRE(arena.bytes() == 0);
+}
+
+TEST_CASE("LP3Arena works like a map of strings", "[arena]")
+{
+    LP3Arena<int> map(256);
+    std::unordered_map<std::string, int> reference;
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<int> length(0, 300);
+    std::uniform_int_distribution<int> action(0, 9);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 2000; i++) {
+        keys.push_back(std::to_string(i) + std::string(length(generator), '/'));
+    }
+    std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+    for (int i = 0; i < 20000; i++) {
+        // a temporary, so a key that pointed at it instead of the arena would dangle
+        std::string key = keys[pick(generator)];
+        switch (action(generator)) {
+            case 0:
+            case 1: REQUIRE(map.erase(key) == reference.erase(key)); break;
+            case 2: REQUIRE(map.insert_or_assign(key, i).second == reference.insert_or_assign(key, i).second); break;
+            case 3: REQUIRE(map.insert(key, i).second == reference.insert({key, i}).second); break;
+            default: map[key] += i; reference[key] += i;
+        }
+    }
+    REQUIRE(map.size() == reference.size());
+    bool same = true;
+    for (const auto& kv : reference) {
+        same = same && map.count(kv.first) == 1 && map.at(kv.first) == kv.second;
+    }
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        same = same && reference.at(std::string(it->first)) == it->second;
+    }
+    REQUIRE(same);
+
+    REQUIRE(map.wasted_bytes() > 0);
+    const size_t bytes = map.arena_bytes();
+    map.compact();
+    REQUIRE(map.wasted_bytes() == 0);
+    REQUIRE(map.arena_bytes() < bytes);
+    for (const auto& kv : reference) {
+        same = same && map.at(kv.first) == kv.second;
+    }
+    REQUIRE(same);
+}
+
+TEST_CASE("string_interner gives equal strings 1 id", "[arena]")
+{
+    LP::string_interner interner;
+    std::vector<LP::string_interner::interned> first;
+    for (int i = 0; i < 10000; i++) {
+        first.push_back(interner.intern("https://example.com/" + std::to_string(i)));
+    }
+    REQUIRE(interner.size() == 10000);
+    bool same = true;
+    for (int i = 0; i < 10000; i++) {
+        const std::string url = "https://example.com/" + std::to_string(i);
+        auto again = interner.intern(url);
+        same = same && again.id == static_cast<uint32_t>(i) && again.id == first[i].id;
+        same = same && again.view.data() == first[i].view.data() && again.view == url;
+        same = same && interner.view(again.id) == url && interner.find(url) == again.id;
+    }
+    REQUIRE(same);
+    REQUIRE(interner.size() == 10000);
+    REQUIRE(interner.find("https://example.com/") == LP::string_interner::not_found);
+    REQUIRE(interner.bytes() > 10000 * 20);
+}
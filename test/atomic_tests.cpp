@@ -0,0 +1,141 @@
+//
+// Tests for LP3Atomic, from 1 and from many threads
+//
+#include <catch2/catch.hpp>
+
+#include <climits>
+#include <thread>
+#include <vector>
+
+#include "./../hashmap_implementations/LPatomic.h"
+
+TEST_CASE("lock-free map from 1 thread", "[atomic]")
+{
+    LP3Atomic<long long, long long> map;
+    REQUIRE(map.empty());
+    for (long long i = -1000; i < 1000; i++) {
+        REQUIRE(map.insert({i * 4294967296ll, i}));
+    }
+    REQUIRE(map.size() == 2000);
+    REQUIRE(map.load_factor() <= map.max_load_factor());
+    REQUIRE_FALSE(map.insert({0, 99}));
+    REQUIRE(map.at(0) == 0);
+    REQUIRE_FALSE(map.insert_or_assign(0, 99));
+    REQUIRE(map.at(0) == 99);
+    REQUIRE(map.fetch_add(0, 1) == 99);
+    REQUIRE(map.fetch_add(5, 7) == 0);
+    REQUIRE(map.at(5) == 7);
+
+    long long expected = 3;
+    REQUIRE_FALSE(map.compare_exchange(5, expected, 10));
+    REQUIRE(expected == 7);
+    REQUIRE(map.compare_exchange(5, expected, 10));
+    REQUIRE(map.at(5) == 10);
+    REQUIRE_FALSE(map.compare_exchange(6, expected, 10));
+    REQUIRE_FALSE(map.contains(6));
+
+    long long value = -1;
+    REQUIRE_FALSE(map.find(1000 * 4294967296ll, value));
+    REQUIRE(value == -1);
+    REQUIRE_THROWS_AS(map.at(12345), std::out_of_range);
+
+    SECTION("the empty key and the reserved values")
+    {
+        REQUIRE_FALSE(map.contains(LLONG_MAX));
+        REQUIRE(map.insert({LLONG_MAX, 1}));
+        REQUIRE(map.fetch_add(LLONG_MAX, 1) == 1);
+        REQUIRE(map.at(LLONG_MAX) == 2);
+        REQUIRE_THROWS_AS(map.insert_or_assign(1, LLONG_MAX), std::invalid_argument);
+        REQUIRE_THROWS_AS(map.insert_or_assign(1, LLONG_MAX - 1), std::invalid_argument);
+        REQUIRE_FALSE(map.contains(1));
+    }
+    SECTION("for_each")
+    {
+        long long sum = 0;
+        size_t seen = 0;
+        map.for_each([&](long long, long long v) {
+            sum += v;
+            seen++;
+        });
+        REQUIRE(seen == map.size());
+        REQUIRE(sum == -1000 + 100 + 10);
+    }
+}
+
+TEST_CASE("lock-free map from many threads", "[atomic]")
+{
+    const int threads = 8;
+    const int per_thread = 50000;
+    // starts tiny, so the threads run into a lot of resizes together
+    LP3Atomic<int, int> map{1};
+
+    SECTION("threads inserting different keys")
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&map, t] {
+                for (int i = t * per_thread; i < (t + 1) * per_thread; i++) {
+                    map.insert({i, -i});
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(map.size() == threads * per_thread);
+        bool passed = true;
+        for (int i = 0; i < threads * per_thread; i++) {
+            if (map.at(i) != -i) {
+                passed = false;
+            }
+        }
+        REQUIRE(passed);
+    }
+    SECTION("threads counting the same keys while the map grows")
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&map, t] {
+                for (int i = 0; i < per_thread; i++) {
+                    map.fetch_add((i * 7 + t) % 20000, 1);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(map.size() == 20000);
+        long long total = 0;
+        map.for_each([&](int, int n) { total += n; });
+        REQUIRE(total == threads * per_thread);
+    }
+    SECTION("readers, reserve and writers together")
+    {
+        std::vector<std::thread> workers;
+        std::vector<int> bad(threads, 0);
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&map, &bad, t] {
+                for (int i = 0; i < per_thread; i++) {
+                    if (t == 0 && i == per_thread / 2) {
+                        map.reserve(1000000);
+                    }
+                    if (t % 2 == 0) {
+                        map.insert_or_assign(i, i);
+                    }
+                    else {
+                        // every key is either missing or has its own value, never anything else
+                        int value = i;
+                        map.find(i, value);
+                        bad[t] += value != i;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(std::count(bad.begin(), bad.end(), 0) == threads);
+        REQUIRE(map.size() == per_thread);
+        REQUIRE(map.bucket_count() * map.max_load_factor() >= 1000000);
+    }
+}
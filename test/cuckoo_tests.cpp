@@ -0,0 +1,93 @@
+//
+// Tests for CuckooMap, and the simple_api wrapper around it
+//
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "./../hashmap_implementations/Cuckoo.h"
+#include "./../simple_api/hashmap.h"
+
+TEST_CASE("cuckoo map stays correct when it's close to full", "[cuckoo]")
+{
+    CuckooMap<std::string, int> map;
+    map.max_load_factor(0.98);
+    std::unordered_map<std::string, int> reference;
+    int* first = &map["first"];
+    for (int i = 0; i < 200000; i++) {
+        map[std::to_string(i)] = i;
+        reference[std::to_string(i)] = i;
+    }
+    REQUIRE(first == &map["first"]);
+    REQUIRE(map.load_factor() <= 0.98f);
+    REQUIRE(map.stash_size() <= 4);
+    bool passed = true;
+    for (const auto& kv : reference) {
+        if (map.at(kv.first) != kv.second) {
+            passed = false;
+        }
+    }
+    REQUIRE(passed);
+    for (int i = 0; i < 200000; i += 3) {
+        map.erase(std::to_string(i));
+    }
+    REQUIRE(map.size() == 200001 - 66667);
+    REQUIRE(map.count("3") == 0);
+    REQUIRE(map.at("4") == 4);
+}
+
+namespace {
+    // every key gets the same hash, so the same 2 buckets at every table size
+    struct Same_hash {
+        size_t operator()(int) const { return 42; }
+    };
+}  // namespace
+
+TEST_CASE("cuckoo map with keys whose hashes collide", "[cuckoo]")
+{
+    // halves that cancel out when the user's hash gets folded to 32 bits
+    CuckooMap<int64_t, int> folded;
+    for (int64_t i = 0; i < 1000; i++) {
+        folded[(i << 32) | i] = static_cast<int>(i);
+    }
+    REQUIRE(folded.size() == 1000);
+    REQUIRE(folded.at((int64_t(999) << 32) | 999) == 999);
+    REQUIRE(folded.stash_size() <= 4);
+
+    // 2 buckets and the stash hold 12 keys with the same hashes, growing can't split them up so the 13th throws
+    CuckooMap<int, int, Same_hash> same;
+    const size_t buckets = same.bucket_count();
+    for (int i = 0; i < 12; i++) {
+        same[i] = i;
+    }
+    REQUIRE_THROWS_AS(same[12], std::overflow_error);
+    REQUIRE(same.size() == 12);
+    REQUIRE(same.count(12) == 0);
+    REQUIRE(same.bucket_count() == buckets);
+    REQUIRE(same.stash_size() == 4);
+    bool passed = true;
+    for (int i = 0; i < 12; i++) {
+        passed = passed && same.at(i) == i;
+    }
+    REQUIRE(passed);
+    REQUIRE(same.erase(3) == 1);
+    REQUIRE(same.count(3) == 0);
+    same[12] = 12;
+    REQUIRE(same.at(12) == 12);
+    REQUIRE(same.stash_size() == 4);
+}
+
+TEST_CASE("simple api cuckoo", "[cuckoo]")
+{
+    Cuckoo cuckoo;
+    PO2_map& map = cuckoo;
+    map.reserve(100);
+    map.insert({1, 10});
+    map[2] = 20;
+    REQUIRE(map[1] == 10);
+    REQUIRE(map.erase(2) == 1);
+    REQUIRE(map.erase(2) == 0);
+    REQUIRE_THROWS_AS(map.insert({1, 2, 3}), std::invalid_argument);
+}
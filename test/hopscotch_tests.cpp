@@ -0,0 +1,77 @@
+//
+// Tests for HopscotchMap
+//
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./../hashmap_implementations/Hopscotch.h"
+
+TEST_CASE("hopscotch map keeps keys in their neighborhood at high load", "[hopscotch]")
+{
+    HopscotchMap<std::string, int> map;
+    map.max_load_factor(0.95);
+    std::unordered_map<std::string, int> reference;
+    int* first = &map["first"];
+    for (int i = 0; i < 100000; i++) {
+        map[std::to_string(i)] = i;
+        reference[std::to_string(i)] = i;
+    }
+    REQUIRE(first == &map["first"]);
+    REQUIRE(map.load_factor() <= 0.95f);
+    bool passed = true;
+    for (const auto& kv : reference) {
+        size_t pos = map.bucket(kv.first);
+        if (map.at(kv.first) != kv.second || map.bucket_size(pos) != 1) {
+            passed = false;
+        }
+    }
+    REQUIRE(passed);
+}
+
+TEST_CASE("hopscotch map with keys that share a home bucket", "[hopscotch]")
+{
+    // 64 bit keys that only differ in the high half, and keys that are a table size apart
+    HopscotchMap<int64_t, int> wide;
+    HopscotchMap<int, int> strided;
+    for (int64_t i = 0; i < 100; i++) {
+        wide[i << 32] = i;
+        strided[i * 479] = i;
+    }
+    REQUIRE(wide.size() == 100);
+    REQUIRE(strided.size() == 100);
+    REQUIRE(wide.at(int64_t(99) << 32) == 99);
+    REQUIRE(strided.at(99 * 479) == 99);
+
+    // halves that cancel out when the key gets folded to 32 bits
+    HopscotchMap<int64_t, int> folded;
+    for (int64_t i = 0; i < 100; i++) {
+        folded[(i << 32) | i] = static_cast<int>(i);
+    }
+    REQUIRE(folded.size() == 100);
+    REQUIRE(folded.at((int64_t(99) << 32) | 99) == 99);
+}
+
+TEST_CASE("hopscotch map fills its last home buckets", "[hopscotch]")
+{
+    // at high load, keys whose home is one of the last buckets get moved into the neighborhood - 1 buckets past the
+    // home ones, and make_room() has to find them room there without looking at owners past the last home bucket
+    std::mt19937 generator(7);
+    bool passed = true;
+    for (int round = 0; round < 200 && passed; round++) {
+        HopscotchMap<int, int> map;
+        map.max_load_factor(0.95);
+        std::vector<int> keys;
+        for (int i = 0; i < 5000; i++) {
+            keys.push_back(static_cast<int>(generator()));
+            map[keys.back()] = i;
+        }
+        for (int key : keys) {
+            passed = passed && map.count(key) == 1 && map.bucket(key) < map.bucket_count() + 31;
+        }
+    }
+    REQUIRE(passed);
+}
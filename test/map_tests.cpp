@@ -0,0 +1,76 @@
+//
+// Tests every map besides LP3 has to pass: LP3Split, CuckooMap and HopscotchMap, next to std::unordered_map
+//
+#include <catch2/catch.hpp>
+
+#include <unordered_map>
+
+#include "./../hashmap_implementations/Cuckoo.h"
+#include "./../hashmap_implementations/Hopscotch.h"
+#include "./../hashmap_implementations/LPsplit.h"
+
+TEMPLATE_TEST_CASE("every map behaves like a map", "[split][cuckoo][hopscotch]", (std::unordered_map<int, int>),
+                   (LP3Split<int, int>), (CuckooMap<int, int>), (HopscotchMap<int, int>))
+{
+    TestType map;
+    for (int i = -1000; i < 1000; i++) {
+        map.insert({i, i + 1});
+    }
+    SECTION("lookups")
+    {
+        REQUIRE(map.size() == 2000);
+        bool passed = true;
+        for (int i = -1000; i < 1000; i++) {
+            if (map[i] != i + 1 || map.at(i) != i + 1 || map.count(i) != 1) {
+                passed = false;
+            }
+        }
+        REQUIRE(passed);
+        REQUIRE(map.count(1000) == 0);
+        REQUIRE(map.find(1000) == map.end());
+        REQUIRE_THROWS_AS(map.at(5000), std::out_of_range);
+    }
+    SECTION("insert doesn't overwrite, insert_or_assign does")
+    {
+        REQUIRE(map.insert({5, 99}).second == false);
+        REQUIRE(map[5] == 6);
+        REQUIRE(map.insert_or_assign(5, 99).second == false);
+        REQUIRE(map[5] == 99);
+    }
+    SECTION("modify through iterators")
+    {
+        for (auto it = map.begin(); it != map.end(); it++) {
+            it->second = it->first * 2;
+        }
+        REQUIRE(map[10] == 20);
+        REQUIRE(map[-1000] == -2000);
+        REQUIRE(map[999] == 1998);
+    }
+    SECTION("erase")
+    {
+        for (int i = -1000; i < 1000; i += 2) {
+            REQUIRE(map.erase(i) == 1);
+        }
+        REQUIRE(map.erase(-1000) == 0);
+        REQUIRE(map.size() == 1000);
+        map.erase(map.find(1));
+        REQUIRE(map.count(1) == 0);
+        REQUIRE(map.size() == 999);
+        // freed slots get reused
+        for (int i = -1000; i < 1000; i += 2) {
+            map[i] = -i;
+        }
+        REQUIRE(map[998] == -998);
+        REQUIRE(map[3] == 4);
+    }
+    SECTION("copy and move")
+    {
+        TestType copy{map};
+        REQUIRE(copy == map);
+        copy[5] = 0;
+        REQUIRE(copy != map);
+        TestType moved{std::move(copy)};
+        REQUIRE(moved.size() == 2000);
+        REQUIRE(moved[5] == 0);
+    }
+}
@@ -0,0 +1,153 @@
+//
+// Tests for LP3::merge_parallel
+//
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./../hashmap_implementations/LPmap3.h"
+
+namespace {
+    // every partial counts a random selection of keys, some of them in every partial
+    template <class Map, class Key, class MakeKey>
+    std::vector<Map> make_partials(const Map& prototype, size_t n, MakeKey make_key,
+                                   std::unordered_map<Key, int>& reference)
+    {
+        std::vector<Map> partials(n, prototype);
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> pick(-20000, 20000);
+        for (auto& partial : partials) {
+            for (int i = 0; i < 10000; i++) {
+                auto key = make_key(pick(gen));
+                partial[key]++;
+                reference[key]++;
+            }
+        }
+        return partials;
+    }
+
+    template <class Map, class Key>
+    bool same_counts(Map& merged, const std::unordered_map<Key, int>& reference)
+    {
+        if (merged.size() != static_cast<int>(reference.size())) {
+            return false;
+        }
+        for (const auto& kv : reference) {
+            if (merged.count(kv.first) != 1 || merged.at(kv.first) != kv.second) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+TEST_CASE("merge_parallel sums counts like inserting one by one", "[merge]")
+{
+    auto add = [](int& into, int&& from) { into += from; };
+    size_t threads = GENERATE(1, 3, 8);
+
+    SECTION("integer keys")
+    {
+        std::unordered_map<int, int> reference;
+        auto partials = make_partials(LP3<int, int>{}, 6, [](int k) { return k; }, reference);
+        auto merged = merge_parallel(partials, add, threads);
+        REQUIRE(same_counts(merged, reference));
+        REQUIRE(merged.load_factor() <= merged.max_load_factor());
+        for (auto& partial : partials) {
+            REQUIRE(partial.empty());
+        }
+        // the spliced elements are ordinary elements
+        merged[100000] = 1;
+        REQUIRE(merged.erase(0) == 1);
+        merged.erase(merged.find(1));
+        REQUIRE(merged.size() == static_cast<int>(reference.size()) + 1 - 2);
+        size_t iterated = 0;
+        for (auto it = merged.begin(); it != merged.end(); it++) {
+            iterated++;
+        }
+        REQUIRE(iterated == static_cast<size_t>(merged.size()));
+    }
+    SECTION("string keys, partials with their own hash state and ones that share it")
+    {
+        std::unordered_map<std::string, int> reference;
+        auto make_key = [](int k) { return std::to_string(k); };
+        auto shared = make_partials(LP3<std::string, int>{}, 4, make_key, reference);
+        std::vector<LP3<std::string, int>> partials(2);
+        std::mt19937 gen(7);
+        for (auto& partial : partials) {
+            for (int i = 0; i < 5000; i++) {
+                auto key = std::to_string(gen() % 30000);
+                partial[key]++;
+                reference[key]++;
+            }
+        }
+        for (auto& partial : shared) {
+            partials.push_back(std::move(partial));
+        }
+        auto merged = merge_parallel(partials, [](int& into, int&& from) { into += from; }, threads);
+        REQUIRE(same_counts(merged, reference));
+    }
+    SECTION("into a map that already has elements")
+    {
+        std::unordered_map<int, int> reference;
+        LP3<int, int> merged;
+        for (int i = 0; i < 100; i++) {
+            merged[i] = 1000;
+            reference[i] = 1000;
+        }
+        merged.max_load_factor(0.9);
+        merged.min_load_factor(0.1);
+        merged.in_place_rehash(true);
+        merged.flood_threshold(64);
+        int resizes = 0;
+        merged.on_resize([&resizes](const LP::Resize_event&) { resizes++; });
+        auto partials = make_partials(LP3<int, int>{}, 3, [](int k) { return k; }, reference);
+        merged.merge_parallel(partials, add, threads);
+        REQUIRE(same_counts(merged, reference));
+
+        // the settings belong to the map, not to the elements that were in it
+        REQUIRE(merged.max_load_factor() == Approx(0.9));
+        REQUIRE(merged.min_load_factor() == Approx(0.1));
+        REQUIRE(merged.in_place_rehash());
+        REQUIRE(merged.flood_threshold() == 64);
+        const size_t buckets = merged.bucket_count();
+        for (int i = 0; merged.load_factor() <= 0.8; i++) {
+            merged[-1 - i] = i;
+        }
+        REQUIRE(merged.bucket_count() == buckets);
+        const int before = resizes;
+        merged.rehash();
+        REQUIRE(resizes > before);
+    }
+}
+
+TEST_CASE("merge_parallel keeps the order of the partials", "[merge]")
+{
+    std::vector<LP3<int, std::string>> partials(5);
+    for (size_t p = 0; p < partials.size(); p++) {
+        for (int k = 0; k < 5000; k++) {
+            partials[p][k] = std::to_string(p);
+        }
+    }
+    auto merged = merge_parallel(partials, [](std::string& into, std::string&& from) { into += from; }, 4);
+    bool passed = true;
+    for (int k = 0; k < 5000; k++) {
+        if (merged.at(k) != "01234") {
+            passed = false;
+        }
+    }
+    REQUIRE(passed);
+}
+
+TEST_CASE("merge_parallel with a probe policy that leaves the ranges", "[merge]")
+{
+    using Map = LP3<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>,
+                    LP::quadratic_probe>;
+    std::unordered_map<int, int> reference;
+    auto partials = make_partials(Map{}, 4, [](int k) { return k; }, reference);
+    auto merged = merge_parallel(partials, [](int& into, int&& from) { into += from; }, 4);
+    REQUIRE(same_counts(merged, reference));
+}
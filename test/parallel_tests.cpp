@@ -0,0 +1,101 @@
+//
+// Tests for LP3's parallel algorithms and the thread pool they run on
+//
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+#include "./../hashmap_implementations/LPmap3.h"
+
+TEST_CASE("thread pool runs every index once and is reusable", "[parallel]")
+{
+    LP::thread_pool pool(4);
+    REQUIRE(pool.size() == 4);
+    for (int job = 0; job < 100; job++) {
+        std::vector<std::atomic<int>> calls(pool.size());
+        pool.run([&](size_t t) { calls[t]++; });
+        for (auto& count : calls) {
+            REQUIRE(count == 1);
+        }
+    }
+    REQUIRE_THROWS_AS(pool.run([](size_t t) {
+                          if (t == 2) {
+                              throw std::runtime_error("thread 2");
+                          }
+                      }),
+                      std::runtime_error);
+    std::atomic<int> after{0};
+    pool.run([&](size_t) { after++; });
+    REQUIRE(after == 4);
+}
+
+TEST_CASE("parallel algorithms match the serial ones", "[parallel]")
+{
+    size_t threads = GENERATE(1, 3, 8);
+    LP::thread_pool pool(threads);
+    LP3<int, int> map;
+    std::unordered_map<int, int> reference;
+    for (int i = 0; i < 50000; i++) {
+        map[i * 7] = i;
+        reference[i * 7] = i;
+    }
+    // holes in the colony and tombstones in the table
+    for (int i = 0; i < 50000; i += 3) {
+        map.erase(i * 7);
+        reference.erase(i * 7);
+    }
+
+    map.for_each([](std::pair<const int, int>& kv) { kv.second *= 2; }, pool);
+    map.transform_values([](const int& key, const int& value) { return value + key; }, pool);
+    for (auto& kv : reference) {
+        kv.second = kv.second * 2 + kv.first;
+    }
+    long long expected = 0;
+    for (auto& kv : reference) {
+        expected += kv.second;
+    }
+    auto to_long = [](const std::pair<const int, int>& kv) { return static_cast<long long>(kv.second); };
+    REQUIRE(map.reduce(5LL, std::plus<long long>{}, to_long, pool) == expected + 5);
+
+    size_t erased = map.erase_if([](const std::pair<const int, int>& kv) { return kv.second % 4 == 0; }, pool);
+    size_t expected_erased = 0;
+    for (auto it = reference.begin(); it != reference.end();) {
+        if (it->second % 4 == 0) {
+            it = reference.erase(it);
+            expected_erased++;
+        }
+        else {
+            it++;
+        }
+    }
+    REQUIRE(erased == expected_erased);
+    REQUIRE(map.size() == static_cast<int>(reference.size()));
+    bool same = true;
+    for (auto& kv : reference) {
+        same = same && map.count(kv.first) == 1 && map.at(kv.first) == kv.second;
+    }
+    REQUIRE(same);
+    // the map keeps working after the tombstones
+    for (int i = 0; i < 50000; i++) {
+        map[-i - 1] = i;
+    }
+    REQUIRE(map.size() == static_cast<int>(reference.size()) + 50000);
+}
+
+TEST_CASE("parallel algorithms on small and empty maps", "[parallel]")
+{
+    LP::thread_pool pool(8);
+    LP3<std::string, std::string> map;
+    auto length = [](const std::pair<const std::string, std::string>& kv) { return kv.second.size(); };
+    REQUIRE(map.reduce(size_t(0), std::plus<size_t>{}, length, pool) == 0);
+    REQUIRE(erase_if(map, [](const std::pair<const std::string, std::string>&) { return true; }, pool) == 0);
+    map["a"] = "1";
+    map["b"] = "22";
+    map.transform_values([](const std::string& key, const std::string& value) { return key + value; }, pool);
+    REQUIRE(map.at("b") == "b22");
+    REQUIRE(map.reduce(size_t(0), std::plus<size_t>{}, length, pool) == 5);
+    REQUIRE(erase_if(map, [](const std::pair<const std::string, std::string>&) { return true; }, pool) == 2);
+    REQUIRE(map.empty());
+}
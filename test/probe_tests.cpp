@@ -0,0 +1,544 @@
+//
+// Tests for LP3's probe policies
+//
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./../hashmap_implementations/LPmap3.h"
+
+namespace {
+    size_t counted_bytes = 0;
+
+    // std::allocator that keeps a running total, for memory_usage().allocator_bytes
+    template <class T>
+    struct Counting_allocator : std::allocator<T> {
+        using value_type = T;
+        template <class U>
+        struct rebind {
+            using other = Counting_allocator<U>;
+        };
+        Counting_allocator() = default;
+        template <class U>
+        Counting_allocator(const Counting_allocator<U>&)
+        {
+        }
+        T* allocate(size_t n)
+        {
+            counted_bytes += n * sizeof(T);
+            return std::allocator<T>::allocate(n);
+        }
+        void deallocate(T* p, size_t n)
+        {
+            counted_bytes -= n * sizeof(T);
+            std::allocator<T>::deallocate(p, n);
+        }
+        size_t allocated_bytes() const { return counted_bytes; }
+    };
+}  // namespace
+
+template <class Probe>
+using probe_map = LP3<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>, Probe>;
+
+TEMPLATE_TEST_CASE("every probe policy behaves like a map", "[probe]", LP::linear_probe, LP::quadratic_probe,
+                   LP::double_hash_probe)
+{
+    probe_map<TestType> map;
+    std::unordered_map<int, int> reference;
+    // sequential keys, the ones that cluster worst, and the keys whose hashes get flipped
+    for (int i = -2; i < 5000; i++) {
+        map.insert({i, i + 1});
+        reference.insert({i, i + 1});
+    }
+    REQUIRE(static_cast<size_t>(map.size()) == reference.size());
+    REQUIRE(map.load_factor() <= TestType::max_load);
+
+    SECTION("lookups")
+    {
+        bool passed = true;
+        for (const auto& kv : reference) {
+            if (map.at(kv.first) != kv.second || map.probe_length(kv.first) < 1) {
+                passed = false;
+            }
+        }
+        REQUIRE(passed);
+        REQUIRE(map.count(-3) == 0);
+        REQUIRE(map.count(5000) == 0);
+    }
+    SECTION("erase, then reinsert over the tombstones")
+    {
+        for (int round = 0; round < 20; round++) {
+            for (int i = -2; i < 5000; i += 3) {
+                REQUIRE(map.erase(i) == 1);
+            }
+            for (int i = -2; i < 5000; i += 3) {
+                map[i] = round;
+            }
+        }
+        REQUIRE(static_cast<size_t>(map.size()) == reference.size());
+        REQUIRE(map[-2] == 19);
+        REQUIRE(map[-1] == 0);
+        REQUIRE(map[4999] == 19);
+        // tombstones count towards the load, so they got cleaned up instead of piling up
+        REQUIRE(map.bucket_count() < 4 * reference.size() / TestType::max_load);
+    }
+    SECTION("rehash keeps the probe sequence")
+    {
+        map.reserve(100000);
+        bool passed = true;
+        for (const auto& kv : reference) {
+            if (map[kv.first] != kv.second) {
+                passed = false;
+            }
+        }
+        REQUIRE(passed);
+    }
+}
+
+TEST_CASE("quadratic probing refuses load factors it can't guarantee", "[probe]")
+{
+    probe_map<LP::quadratic_probe> map;
+    REQUIRE_THROWS_AS(map.max_load_factor(0.75), std::out_of_range);
+    map.max_load_factor(0.4);
+    for (int i = 0; i < 1000; i++) {
+        map[i] = i;
+    }
+    REQUIRE(map.load_factor() <= 0.4f);
+}
+
+TEST_CASE("operator[] grows the table", "[probe]")
+{
+    LP3<int, int> map;
+    for (int i = 0; i < 100000; i++) {
+        map[i] = i;
+    }
+    REQUIRE(map.load_factor() <= map.max_load_factor());
+    REQUIRE(map[99999] == 99999);
+}
+
+TEMPLATE_TEST_CASE("erasing through iterators finds the right bucket after rehashes and copies", "[probe]",
+                   LP::linear_probe, LP::quadratic_probe, LP::double_hash_probe)
+{
+    using Map = LP3<std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+                    std::allocator<std::pair<const std::string, int>>, TestType>;
+    Map grown;
+    for (int i = 0; i < 5000; i++) {
+        grown[std::to_string(i)] = i;  // grows several times on the way
+    }
+    for (int i = 0; i < 5000; i += 5) {
+        grown.erase(std::to_string(i));  // tombstones, which the copy takes over
+    }
+    Map copy{grown};
+    for (Map* map : {&grown, &copy}) {
+        size_t erased = erase_if(*map, [](const std::pair<const std::string, int>& kv) { return kv.second % 2 == 0; });
+        REQUIRE(erased == 2000);
+        auto it = map->begin();
+        it = map->erase(it);
+        map->erase(it, map->end());
+        REQUIRE(map->empty());
+        for (int i = 0; i < 5000; i++) {
+            REQUIRE(map->count(std::to_string(i)) == 0);
+        }
+        (*map)["again"] = 1;
+        REQUIRE(map->at("again") == 1);
+    }
+}
+
+TEST_CASE("clear keeps the bucket count and forgets everything, also when the generation wraps", "[probe]")
+{
+    LP3<int, int> map;
+    for (int i = 0; i < 10000; i++) {
+        map[i] = i;
+    }
+    const size_t buckets = map.bucket_count();
+    bool passed = true;
+    for (int round = 1; round <= 600; round++) {
+        map.clear();
+        passed = passed && map.empty() && map.bucket_count() == buckets && map.count(round % 50) == 0;
+        // a few keys per round, some of them in buckets an earlier generation used too
+        for (int i = 0; i < 50; i++) {
+            map[i * round] = round;
+        }
+        passed = passed && map.size() == 50 && map.at(49 * round) == round && map.count(50 * round) == 0;
+    }
+    REQUIRE(passed);
+    map.erase(0);
+    auto copy = map;
+    REQUIRE(copy.size() == 49);
+    REQUIRE(copy.at(600) == 600);
+    REQUIRE(copy.count(0) == 0);
+}
+
+TEST_CASE("a huge reserve only costs the buckets that get used", "[probe]")
+{
+    LP3<int, int> map;
+    map.reserve(50000000);  // 400MB of buckets, if they'd all get written
+    REQUIRE(map.bucket_count() >= 100000000);
+    REQUIRE(map.empty());
+    for (int i = 0; i < 1000; i++) {
+        map[i * 100003] = i;
+    }
+    REQUIRE(map.size() == 1000);
+    REQUIRE(map.at(999 * 100003) == 999);
+    REQUIRE(map.count(1) == 0);
+    auto copy = map;
+    copy.erase(0);
+    REQUIRE(copy.size() == 999);
+    REQUIRE(map.size() == 1000);
+}
+
+TEMPLATE_TEST_CASE("in place rehashing grows, cleans up and shrinks like rehash", "[probe]", LP::linear_probe,
+                   LP::quadratic_probe, LP::double_hash_probe)
+{
+    using Map = LP3<std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+                    std::allocator<std::pair<const std::string, int>>, TestType>;
+    Map map;
+    map.in_place_rehash(true);
+    std::unordered_map<std::string, int> reference;
+    auto same = [&] {
+        if (map.size() != static_cast<int>(reference.size()) || map.load_factor() > map.max_load_factor()) {
+            return false;
+        }
+        for (const auto& kv : reference) {
+            if (map.count(kv.first) != 1 || map.at(kv.first) != kv.second) {
+                return false;
+            }
+        }
+        size_t iterated = 0;
+        for (auto it = map.begin(); it != map.end(); it++) {
+            iterated++;
+        }
+        return iterated == reference.size();
+    };
+    for (int i = 0; i < 20000; i++) {
+        map[std::to_string(i)] = i;  // grows in place a few times
+        reference[std::to_string(i)] = i;
+    }
+    REQUIRE(same());
+    for (int i = 0; i < 20000; i += 3) {
+        map.erase(std::to_string(i));
+        reference.erase(std::to_string(i));
+    }
+    const size_t buckets = map.bucket_count();
+    map.purge_tombstones();
+    REQUIRE(map.bucket_count() == buckets);
+    REQUIRE(same());
+    // iterator erase needs the nodes to know their new buckets
+    erase_if(map, [](const std::pair<const std::string, int>& kv) { return kv.second % 3 == 1; });
+    for (auto it = reference.begin(); it != reference.end();) {
+        it = it->second % 3 == 1 ? reference.erase(it) : std::next(it);
+    }
+    map.rehash();  // sized for what's left, which is a lot smaller
+    REQUIRE(map.bucket_count() < buckets);
+    REQUIRE(same());
+    map.reserve(100000);
+    REQUIRE(same());
+    REQUIRE(map.count("-1") == 0);
+}
+
+TEST_CASE("shrinking after erases", "[probe]")
+{
+    LP3<int, std::string> map;
+    for (int i = 0; i < 100000; i++) {
+        map[i] = std::to_string(i);
+    }
+    const size_t full = map.bucket_count();
+    REQUIRE_THROWS_AS(map.min_load_factor(map.max_load_factor() / 2), std::out_of_range);
+
+    SECTION("shrink_to_fit packs the table and the colony")
+    {
+        for (int i = 0; i < 100000; i++) {
+            if (i % 10 != 0) {
+                map.erase(i);
+            }
+        }
+        REQUIRE(map.bucket_count() == full);
+        map.shrink_to_fit();
+        REQUIRE(map.bucket_count() < full / 5);
+        REQUIRE(map.load_factor() <= map.max_load_factor());
+        bool passed = map.size() == 10000;
+        for (int i = 0; i < 100000; i += 10) {
+            passed = passed && map.at(i) == std::to_string(i);
+        }
+        REQUIRE(passed);
+        erase_if(map, [](const std::pair<const int, std::string>& kv) { return kv.first % 20 == 0; });
+        REQUIRE(map.size() == 5000);
+        REQUIRE(map.count(20) == 0);
+        REQUIRE(map.at(10) == "10");
+    }
+    SECTION("min_load_factor shrinks on its own, with room to grow back")
+    {
+        map.min_load_factor(0.1);
+        REQUIRE_THROWS_AS(map.max_load_factor(0.2), std::out_of_range);
+        auto it = map.begin();
+        while (map.size() > 1000) {
+            it = map.erase(it);  // shrinking mid way doesn't invalidate it
+        }
+        REQUIRE(map.bucket_count() < full / 10);
+        REQUIRE(map.load_factor() >= map.min_load_factor());
+        size_t iterated = 0;
+        for (auto& kv : map) {
+            iterated += map.at(kv.first) == kv.second;
+        }
+        REQUIRE(iterated == 1000);
+        const size_t shrunk = map.bucket_count();
+        for (int i = 0; i < 100; i++) {
+            map[-i - 1] = "new";
+            map.erase(-i - 1);
+        }
+        REQUIRE(map.bucket_count() == shrunk);
+    }
+}
+
+TEST_CASE("compact puts the elements in bucket order", "[probe]")
+{
+    LP3<std::string, std::string> map;
+    std::unordered_map<std::string, std::string> reference;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 20000; i++) {
+            map[std::to_string(i + round * 20000)] = std::to_string(i);
+        }
+        for (int i = 0; i < 20000; i++) {
+            if (i % 4 != 0) {
+                map.erase(std::to_string(i + round * 20000));
+            }
+        }
+    }
+    for (auto& kv : map) {
+        reference.insert(kv);
+    }
+    map.compact();
+    REQUIRE(map.size() == static_cast<int>(reference.size()));
+    bool in_order = true;
+    bool same = true;
+    size_t last_bucket = 0;
+    for (auto& kv : map) {
+        size_t bucket = map.bucket(kv.first);
+        in_order = in_order && bucket >= last_bucket;
+        last_bucket = bucket;
+        same = same && reference.at(kv.first) == kv.second;
+    }
+    REQUIRE(in_order);
+    REQUIRE(same);
+    // the handles point into the new colony
+    map.erase(map.begin());
+    REQUIRE(map.erase("4") == 1);
+    map["new"] = "1";
+    REQUIRE(map.size() == static_cast<int>(reference.size()) - 1);
+}
+
+TEST_CASE("memory_usage adds up", "[probe]")
+{
+    LP3<int, int> map;
+    auto empty = map.memory_usage();
+    REQUIRE(empty.live_slots == 0);
+    REQUIRE(empty.stamps_bytes == map.bucket_count());
+    REQUIRE(empty.random_state_bytes == 0);  // LP::default_tabulation() is shared
+    REQUIRE(empty.bytes_per_element() == 0);
+    REQUIRE(empty.allocator_bytes == 0);
+
+    for (int i = 0; i < 100000; i++) {
+        map[i] = i;
+    }
+    auto full = map.memory_usage();
+    REQUIRE(full.live_slots == 100000);
+    REQUIRE(full.erased_slots == 0);
+    REQUIRE(full.colony_groups > 0);
+    REQUIRE(full.colony_capacity >= full.live_slots);
+    REQUIRE(full.colony_bytes > full.colony_capacity * sizeof(std::pair<const int, int>));
+    REQUIRE(full.skipfield_bytes < full.colony_bytes);
+    REQUIRE(full.hash_store_bytes == map.bucket_count() * sizeof(int32_t));
+    REQUIRE(full.total() == full.bucket_bytes() + full.random_state_bytes + full.colony_bytes);
+    REQUIRE(full.overhead_ratio() > 1);
+    REQUIRE(full.bytes_per_element() == Approx(full.overhead_ratio() * full.element_bytes));
+
+    for (int i = 0; i < 100000; i += 2) {
+        map.erase(i);
+    }
+    auto erased = map.memory_usage();
+    REQUIRE(erased.live_slots == 50000);
+    REQUIRE(erased.erased_slots + erased.live_slots <= erased.colony_capacity);
+    REQUIRE(erased.erased_slots > 0);
+    map.compact();
+    REQUIRE(map.memory_usage().erased_slots == 0);
+
+    SECTION("an allocator that counts")
+    {
+        using Map = LP3<int, int, std::hash<int>, std::equal_to<int>, Counting_allocator<std::pair<const int, int>>>;
+        Map counted;
+        for (int i = 0; i < 10000; i++) {
+            counted[i] = i;
+        }
+        auto usage = counted.memory_usage();
+        REQUIRE(usage.allocator_bytes == counted_bytes);
+        REQUIRE(usage.allocator_bytes > 0);
+        REQUIRE(usage.allocator_bytes <= usage.colony_bytes);
+    }
+}
+
+TEMPLATE_TEST_CASE("analyze agrees with probing", "[probe]", LP::linear_probe, LP::quadratic_probe,
+                   LP::double_hash_probe)
+{
+    probe_map<TestType> map;
+    std::vector<int> keys;
+    for (int i = 0; i < 3000; i++) {
+        keys.push_back(i % 3 ? i * 7919 : i);  // a third of them sequential, to get some clusters
+        map[keys.back()] = i;
+    }
+    auto table = map.analyze(10);
+    REQUIRE(table.buckets == map.bucket_count());
+    REQUIRE(table.live == 3000);
+    REQUIRE(table.tombstones == 0);
+    size_t probes = 0;
+    size_t longest = 0;
+    for (int key : keys) {
+        probes += map.probe_length(key);
+        longest = std::max(longest, map.probe_length(key));
+    }
+    REQUIRE(table.mean_probe_length == Approx(probes / 3000.0));
+    REQUIRE(table.max_probe_length == longest);
+    size_t counted = 0;
+    for (size_t n : table.probe_lengths) {
+        counted += n;
+    }
+    REQUIRE(counted == 3000);
+
+    // the longest run of occupied buckets, wrapping around the end
+    size_t run = 0;
+    size_t longest_run = 0;
+    for (size_t i = 0; i < 2 * map.bucket_count(); i++) {
+        run = map.bucket_size(i % map.bucket_count()) ? run + 1 : 0;
+        longest_run = std::max(longest_run, run);
+    }
+    REQUIRE(table.largest_cluster_length == longest_run);
+    REQUIRE(map.bucket_size(table.largest_cluster_start) == 1);
+    REQUIRE(map.bucket_size((table.largest_cluster_start + longest_run) % map.bucket_count()) == 0);
+    if (std::is_same<TestType, LP::linear_probe>{}) {
+        // an unsuccessful lookup from every home bucket
+        double walked = 0;
+        for (size_t home = 0; home < map.bucket_count(); home++) {
+            size_t pos = home;
+            while (map.bucket_size(pos)) {
+                pos = (pos + 1) % map.bucket_count();
+                walked++;
+            }
+            walked++;
+        }
+        REQUIRE(table.expected_miss_length == Approx(walked / map.bucket_count()));
+    }
+
+    for (int i = 0; i < 1500; i++) {
+        map.erase(keys[i]);
+    }
+    table = map.analyze(10);
+    REQUIRE(table.live == 1500);
+    REQUIRE(table.tombstones == 1500);
+    REQUIRE(table.tombstone_density.size() == 10);
+    float density = 0;
+    for (float d : table.tombstone_density) {
+        density += d;
+    }
+    REQUIRE(density / 10 == Approx(1500.0 / map.bucket_count()).epsilon(0.01));
+}
+
+TEST_CASE("keys picked to collide get a reseed", "[probe]")
+{
+    std::vector<LP::Resize_event> events;
+    auto attack = [&](LP3<long, int>& map) {
+        map.reserve(5000);
+        map.on_resize([&](const LP::Resize_event& event) { events.push_back(event); });
+        const long buckets = map.bucket_count();
+        // integers are their own hash, so multiples of the bucket count all want bucket 0
+        for (long i = 0; i < 2000; i++) {
+            map[i * buckets] = static_cast<int>(i);
+        }
+        return buckets;
+    };
+
+    LP3<long, int> defended;
+    const long buckets = attack(defended);
+    REQUIRE(defended.bucket_count() == static_cast<size_t>(buckets));
+    REQUIRE(defended.analyze().max_probe_length < 40);
+    REQUIRE(std::any_of(events.begin(), events.end(),
+                        [](const LP::Resize_event& e) { return e.cause == LP::Resize_cause::reseed; }));
+    bool found = true;
+    for (long i = 0; i < 2000; i++) {
+        found = found && defended.at(i * buckets) == i;
+    }
+    REQUIRE(found);
+    REQUIRE(defended.count(1) == 0);
+
+    events.clear();
+    LP3<long, int> open;
+    open.flood_threshold(0);
+    attack(open);
+    REQUIRE(open.analyze().max_probe_length == 2000);
+    REQUIRE(events.empty());
+}
+
+TEST_CASE("reseed keeps the elements and the iterators", "[probe]")
+{
+    LP3<std::string, int> map;
+    for (int i = 0; i < 5000; i++) {
+        map[std::to_string(i)] = i;
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        map.erase(std::to_string(i));
+    }
+    auto it = map.find("1");
+    int* value = &map.at("2");
+    map.reseed();
+    REQUIRE(it->second == 1);
+    REQUIRE(value == &map.at("2"));
+    bool found = true;
+    for (int i = 0; i < 5000; i++) {
+        found = found && map.count(std::to_string(i)) == (i % 3 != 0);
+    }
+    REQUIRE(found);
+    REQUIRE(map.analyze().tombstones == 0);
+
+    // copies and merges hash the same way
+    auto copy = map;
+    REQUIRE(copy == map);
+    copy["new"] = 1;
+    REQUIRE(copy.at("new") == 1);
+}
+
+namespace {
+    // differs only in the top half, where a hash truncated to 32 bits loses it
+    struct High_hash {
+        size_t operator()(const std::string& key) const { return static_cast<size_t>(std::stoull(key)) << 32; }
+    };
+}  // namespace
+
+TEST_CASE("tabulation hashes all 8 bytes", "[probe]")
+{
+    LP3<std::string, int, High_hash> map;
+    for (int i = 0; i < 10000; i++) {
+        map[std::to_string(i)] = i;
+    }
+    REQUIRE(map.analyze().max_probe_length < 40);
+    REQUIRE(map.at("1234") == 1234);
+
+    std::mt19937_64 generator(7);
+    std::vector<uint64_t> hashes(1001);
+    for (auto& hash : hashes) {
+        hash = generator();
+    }
+    std::vector<int32_t> batch(hashes.size());
+    LP::tabulate(hashes.data(), hashes.size(), batch.data(), LP::default_tabulation());
+    bool same = true;
+    for (size_t i = 0; i < hashes.size(); i++) {
+        same = same && batch[i] == LP::tabulate(hashes[i], LP::default_tabulation()) && batch[i] >= 0;
+    }
+    REQUIRE(same);
+
+    REQUIRE(map.memory_usage().random_state_bytes == 0);
+    map.reseed();
+    REQUIRE(map.memory_usage().random_state_bytes == sizeof(LP::tabulation_table));
+    REQUIRE(map.at("1234") == 1234);
+}
@@ -0,0 +1,98 @@
+//
+// Tests for LP3Rcu and the epoch reclamation under it
+//
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./../hashmap_implementations/LPrcu.h"
+
+TEST_CASE("rcu map from 1 thread", "[rcu]")
+{
+    LP3Rcu<std::string, int> map;
+    REQUIRE(map.empty());
+    map.reserve(2000);
+    for (int i = 0; i < 2000; i++) {
+        REQUIRE(map.insert({std::to_string(i), i}));
+    }
+    REQUIRE(map.size() == 2000);
+    REQUIRE_FALSE(map.insert({"5", 99}));
+    REQUIRE_FALSE(map.insert_or_assign("5", 99));
+    REQUIRE(map.at("5") == 99);
+    int value = -1;
+    REQUIRE_FALSE(map.find("2000", value));
+    REQUIRE(value == -1);
+    REQUIRE_THROWS_AS(map.at("2000"), std::out_of_range);
+    REQUIRE(map.erase("0") == 1);
+    REQUIRE_FALSE(map.contains("0"));
+
+    // a batch shows up all at once
+    map.update([](LP3Rcu<std::string, int>::Map& m) {
+        m.erase("1");
+        m["extra"] = -1;
+    });
+    REQUIRE(map.size() == 1999);
+    REQUIRE(map.read([](const LP3Rcu<std::string, int>::Map& m) { return m.count("1") + m.count("extra"); }) == 1);
+
+    // reads nest, a lookup inside read() doesn't end the outer read
+    size_t seen = map.read([&](const LP3Rcu<std::string, int>::Map& m) {
+        size_t n = 0;
+        for (auto it = m.cbegin(); it != m.cend(); it++) {
+            n += map.contains(it->first);
+        }
+        return n;
+    });
+    REQUIRE(seen == 1999);
+    map.clear();
+    REQUIRE(map.empty());
+}
+
+TEST_CASE("rcu map readers next to a writer", "[rcu]")
+{
+    const int threads = 8;
+    const int keys = 1000;
+    LP3Rcu<int, int> map;
+    // every version has value == key + version for all keys, so a reader can tell if it saw a mix of 2 versions
+    map.update([&](LP3Rcu<int, int>::Map& m) {
+        for (int i = 0; i < keys; i++) {
+            m[i] = i;
+        }
+    });
+
+    std::atomic<bool> done{false};
+    std::vector<int> torn(threads, 0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; t++) {
+        readers.emplace_back([&, t] {
+            while (!done.load()) {
+                torn[t] += map.read([&](const LP3Rcu<int, int>::Map& m) {
+                    int version = m.at(0);
+                    for (int i = 1; i < keys; i++) {
+                        if (m.at(i) != i + version) {
+                            return 1;
+                        }
+                    }
+                    return 0;
+                });
+                int value = -1;
+                torn[t] += !map.find(keys - 1, value);
+            }
+        });
+    }
+    for (int version = 1; version <= 200; version++) {
+        map.update([&](LP3Rcu<int, int>::Map& m) {
+            for (int i = 0; i < keys; i++) {
+                m[i] = i + version;
+            }
+        });
+    }
+    done.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(std::count(torn.begin(), torn.end(), 0) == threads);
+    REQUIRE(map.at(0) == 200);
+}
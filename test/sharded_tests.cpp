@@ -0,0 +1,127 @@
+//
+// Tests for LP3Sharded, from 1 and from many threads
+//
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./../hashmap_implementations/LPsharded.h"
+
+TEST_CASE("sharded map from 1 thread", "[sharded]")
+{
+    LP3Sharded<int, int> map{5};
+    REQUIRE(map.shard_count() == 8);
+    REQUIRE(map.empty());
+    map.reserve(2000);
+    for (int i = -1000; i < 1000; i++) {
+        REQUIRE(map.insert({i, i + 1}));
+    }
+    REQUIRE(map.size() == 2000);
+    REQUIRE_FALSE(map.insert({5, 99}));
+    REQUIRE(map.at(5) == 6);
+    REQUIRE_FALSE(map.insert_or_assign(5, 99));
+    REQUIRE(map.at(5) == 99);
+    int value = 0;
+    REQUIRE_FALSE(map.find(1000, value));
+    REQUIRE(value == 0);
+    REQUIRE(map.find(-1000, value));
+    REQUIRE(value == -999);
+    REQUIRE_THROWS_AS(map.at(5000), std::out_of_range);
+    REQUIRE(map.erase(-1000) == 1);
+    REQUIRE(map.erase(-1000) == 0);
+    REQUIRE_FALSE(map.contains(-1000));
+
+    long long sum = 0;
+    size_t seen = 0;
+    map.for_each([&](const std::pair<const int, int>& kv) {
+        sum += kv.second - kv.first;
+        seen++;
+    });
+    REQUIRE(seen == 1999);
+    REQUIRE(sum == 1998 + (99 - 5));
+    map.clear();
+    REQUIRE(map.empty());
+}
+
+TEST_CASE("sharded map from many threads", "[sharded]")
+{
+    const int threads = 8;
+    const int per_thread = 20000;
+    LP3Sharded<int, int> map;
+
+    SECTION("threads inserting different keys")
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&map, t] {
+                for (int i = t * per_thread; i < (t + 1) * per_thread; i++) {
+                    map.insert({i, -i});
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(map.size() == threads * per_thread);
+        bool passed = true;
+        for (int i = 0; i < threads * per_thread; i++) {
+            if (map.at(i) != -i) {
+                passed = false;
+            }
+        }
+        REQUIRE(passed);
+    }
+    SECTION("threads counting the same keys")
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&map] {
+                for (int i = 0; i < per_thread; i++) {
+                    map.update(i % 100, [](int& n) { n++; });
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(map.size() == 100);
+        bool passed = true;
+        map.for_each([&](const std::pair<const int, int>& kv) {
+            if (kv.second != threads * per_thread / 100) {
+                passed = false;
+            }
+        });
+        REQUIRE(passed);
+    }
+    SECTION("readers next to writers")
+    {
+        for (int i = 0; i < per_thread; i++) {
+            map.insert({i, i});
+        }
+        std::vector<std::thread> workers;
+        std::vector<int> bad(threads, 0);
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&map, &bad, t] {
+                for (int i = 0; i < per_thread; i++) {
+                    if (t % 2 == 0) {
+                        map.erase(i);
+                        map.insert({i, i});
+                    }
+                    else {
+                        // every key is either missing or has its own value, never anything else
+                        int value = i;
+                        map.find(i, value);
+                        bad[t] += value != i;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(std::count(bad.begin(), bad.end(), 0) == threads);
+        REQUIRE(map.size() == per_thread);
+    }
+}
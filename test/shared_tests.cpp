@@ -0,0 +1,148 @@
+//
+// Tests for LP3Shared
+//
+#include <catch2/catch.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "./../hashmap_implementations/LPshared.h"
+
+namespace {
+    // shm names are global, so every test run gets its own
+    std::string segment_name(const char* test)
+    {
+        return "/lp3_" + std::string(test) + "_" + std::to_string(getpid());
+    }
+
+    struct Point {
+        double x;
+        double y;
+    };
+}  // namespace
+
+TEST_CASE("shared map in 1 process", "[shared]")
+{
+    const std::string name = segment_name("single");
+    LP3Shared<int, Point>::remove(name);
+    auto map = LP3Shared<int, Point>::create(name, 1000);
+    REQUIRE(map.empty());
+    REQUIRE(map.capacity() == 1000);
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE(map.insert(i, Point{i * 0.5, -i * 0.5}));
+    }
+    REQUIRE(map.size() == 1000);
+    REQUIRE(map.load_factor() <= map.max_load_factor());
+    REQUIRE_FALSE(map.insert(5, Point{0, 0}));
+    REQUIRE_THROWS_AS(map.insert(1000, Point{0, 0}), std::length_error);
+    REQUIRE(map.at(999).x == 499.5);
+    REQUIRE_THROWS_AS(map.at(-1), std::out_of_range);
+
+    // erasing and inserting over and over reuses the nodes and cleans up the tombstones
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 500; i++) {
+            REQUIRE(map.erase(i + round * 500) == 1);
+        }
+        for (int i = 0; i < 500; i++) {
+            REQUIRE(map.insert(1000 + i + round * 500, Point{1, 2}));
+        }
+    }
+    REQUIRE(map.size() == 1000);
+    size_t seen = 0;
+    map.for_each([&](const LP3Shared<int, Point>::Node& node) { seen += node.first >= 10000; });
+    REQUIRE(seen == 1000);
+    REQUIRE_FALSE(map.insert_or_assign(10000, Point{3, 4}));
+    REQUIRE(map.at(10000).y == 4);
+    map.clear();
+    REQUIRE(map.empty());
+    LP3Shared<int, Point>::remove(name);
+}
+
+TEST_CASE("shared map attaching", "[shared]")
+{
+    const std::string name = segment_name("attach");
+    using Map = LP3Shared<long, int>;
+    Map::remove(name);
+    REQUIRE_THROWS_AS(Map::open(name), std::system_error);
+    // the bucket count, next_prime(2 * capacity + 1), has to fit in an int32_t
+    REQUIRE_THROWS_AS(Map::create(name, 912130989), std::length_error);
+    REQUIRE_THROWS_AS(Map::create(name, 1500000000), std::length_error);
+    REQUIRE_THROWS_AS(Map::open(name), std::system_error);
+    auto map = Map::create(name, 100);
+    REQUIRE_THROWS_AS(Map::create(name, 100), std::system_error);
+    REQUIRE_THROWS_AS((LP3Shared<long, long>::open(name)), std::runtime_error);
+
+    auto writer = Map::open(name, Map::Access::read_write);
+    REQUIRE(writer.insert(7, 70));
+    auto reader = Map::open(name);
+    REQUIRE(reader.at(7) == 70);
+    REQUIRE(map.contains(7));
+    REQUIRE_THROWS_AS(reader.insert(8, 80), std::logic_error);
+    auto moved = Map::open(name);
+    moved = std::move(reader);
+    REQUIRE(moved.at(7) == 70);
+    Map::remove(name);
+    // still mapped after the name is gone
+    REQUIRE(moved.at(7) == 70);
+}
+
+TEST_CASE("shared map read by another process", "[shared]")
+{
+    const std::string name = segment_name("fork");
+    using Map = LP3Shared<size_t, int>;
+    struct Key {
+        char text[16];
+    };
+    struct Key_hash {
+        size_t operator()(const Key& key) const { return std::hash<std::string>{}(key.text); }
+    };
+    struct Key_equal {
+        bool operator()(const Key& a, const Key& b) const { return std::string(a.text) == b.text; }
+    };
+    using Text_map = LP3Shared<Key, int, Key_hash, Key_equal>;
+    Map::remove(name);
+    Text_map::remove(name + "_text");
+    auto map = Map::create(name, 20000);
+    auto text_map = Text_map::create(name + "_text", 2000);
+    for (size_t i = 0; i < 20000; i++) {
+        map.insert(i * 31, static_cast<int>(i));
+    }
+    for (int i = 0; i < 2000; i++) {
+        Key key{};
+        snprintf(key.text, sizeof(key.text), "key%d", i);
+        text_map.insert(key, i);
+    }
+
+    pid_t child = fork();
+    REQUIRE(child != -1);
+    if (child == 0) {
+        // a fresh mapping, at whatever address this process gets, and a tabulation state it didn't draw
+        int failed = 0;
+        try {
+            auto reader = Map::open(name);
+            auto text_reader = Text_map::open(name + "_text");
+            for (size_t i = 0; i < 20000; i++) {
+                int value = -1;
+                failed += !reader.find(i * 31, value) || value != static_cast<int>(i);
+            }
+            failed += reader.contains(1);
+            for (int i = 0; i < 2000; i++) {
+                Key key{};
+                snprintf(key.text, sizeof(key.text), "key%d", i);
+                failed += text_reader.at(key) != i;
+            }
+        }
+        catch (...) {
+            failed = 1;
+        }
+        _exit(failed == 0 ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+    Map::remove(name);
+    Text_map::remove(name + "_text");
+}
@@ -0,0 +1,93 @@
+//
+// Tests for LP3Split, the map that keeps keys and values in separate stores
+//
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "./../benchmarks/includes/bigtype.h"
+#include "./../hashmap_implementations/LPsplit.h"
+
+TEST_CASE("split storage keeps references stable and big values intact", "[split]")
+{
+    LP3Split<std::string, Big> map;
+    map["first"] = Big{1};
+    Big* first = &map["first"];
+    for (int i = 0; i < 10000; i++) {
+        map.insert({std::to_string(i), Big{i}});
+    }
+    REQUIRE(first == &map["first"]);
+    REQUIRE(map.at("first") == Big{1});
+    REQUIRE(map.at("9999") == Big{9999});
+    map.clear();
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.begin() == map.end());
+}
+
+TEST_CASE("split storage under insert and erase churn", "[split]")
+{
+    // every erase leaves a tombstone, and a table full of them has no EMPTY bucket to end a probe
+    LP3Split<int, int> churn;
+    for (int i = 0; i < 5000; i++) {
+        REQUIRE(churn.insert({i, i}).second);
+        REQUIRE(churn.erase(i) == 1);
+    }
+    REQUIRE(churn.empty());
+    REQUIRE(churn.insert({-1, 1}).second);
+    REQUIRE(churn.count(4999) == 0);
+
+    LP3Split<int, int> map;
+    std::unordered_map<int, int> reference;
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<int> key(0, 400);
+    std::uniform_int_distribution<int> action(0, 3);
+    bool same = true;
+    for (int step = 0; step < 50000 && same; step++) {
+        const int k = key(generator);
+        switch (action(generator)) {
+            case 0: same = map.erase(k) == reference.erase(k); break;
+            case 1: same = map.insert({k, step}).second == reference.insert({k, step}).second; break;
+            case 2: same = map.insert_or_assign(k, step).second == reference.insert_or_assign(k, step).second; break;
+            default: same = map.count(k) == reference.count(k);
+        }
+        same = same && map.size() == static_cast<int>(reference.size());
+    }
+    REQUIRE(same);
+    for (const auto& kv : reference) {
+        same = same && map.at(kv.first) == kv.second;
+    }
+    REQUIRE(same);
+}
+
+namespace {
+    // differs only in the top half, where a hash truncated to 32 bits loses it
+    struct High_hash {
+        size_t operator()(const std::string& key) const { return static_cast<size_t>(std::stoull(key)) << 32; }
+    };
+    // counts key compares, which only happen when the tabulated hashes match
+    struct Counting_equal {
+        static inline size_t calls = 0;
+        bool operator()(const std::string& a, const std::string& b) const
+        {
+            calls++;
+            return a == b;
+        }
+    };
+}  // namespace
+
+TEST_CASE("split storage tabulates all 8 bytes of the hash", "[split]")
+{
+    LP3Split<std::string, int, High_hash, Counting_equal> map;
+    for (int i = 0; i < 2000; i++) {
+        map[std::to_string(i)] = i;
+    }
+    Counting_equal::calls = 0;
+    bool found = true;
+    for (int i = 0; i < 2000; i++) {
+        found = found && map.at(std::to_string(i)) == i;
+    }
+    REQUIRE(found);
+    REQUIRE(Counting_equal::calls < 2100);
+}
@@ -0,0 +1,103 @@
+//
+// Tests for LP3's Stats policy
+//
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./../hashmap_implementations/LPmap3.h"
+
+namespace {
+    template <class Tag>
+    using counted_map = LP3<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>,
+                            LP::linear_probe, LP::counting_stats<Tag>>;
+
+    // every key gets the same hash
+    struct Same_hash {
+        size_t operator()(const std::string&) const { return 42; }
+    };
+}  // namespace
+
+TEST_CASE("counting_stats sees inserts, erases and rehashes", "[stats]")
+{
+    struct Tag {};
+    using Stats = LP::counting_stats<Tag>;
+    Stats::reset();
+    counted_map<Tag> map;
+    for (int i = 0; i < 10000; i++) {
+        map[i] = i;
+    }
+    auto counters = Stats::snapshot();
+    REQUIRE(counters.lookups >= 10000);
+    REQUIRE(counters.probes >= counters.lookups);
+    REQUIRE(counters.rehashes > 0);
+    REQUIRE(counters.colony_allocations > 0);
+    REQUIRE(counters.tombstones_created == 0);
+    REQUIRE(counters.key_mismatches == 0);  // integers are their own hash
+
+    Stats::reset();
+    for (int i = 0; i < 100; i++) {
+        map.erase(i);
+    }
+    map.erase(map.find(200));
+    REQUIRE(Stats::snapshot().tombstones_created == 101);
+    REQUIRE(Stats::snapshot().lookups == 101);
+    map.purge_tombstones();
+    map.rehash();
+    counters = Stats::snapshot();
+    REQUIRE(counters.rehashes == 2);
+    REQUIRE(counters.tombstones_purged == 101);
+    REQUIRE(counters.mean_probes() >= 1);
+}
+
+TEST_CASE("counting_stats counts keys with the same hash", "[stats]")
+{
+    struct Tag {};
+    using Stats = LP::counting_stats<Tag>;
+    LP3<std::string, int, Same_hash, std::equal_to<std::string>, std::allocator<std::pair<const std::string, int>>,
+        LP::linear_probe, Stats>
+        map;
+    for (int i = 0; i < 10; i++) {
+        map[std::to_string(i)] = i;
+    }
+    // the nth key walks over the n - 1 before it
+    REQUIRE(Stats::snapshot().key_mismatches == 45);
+}
+
+TEST_CASE("counting_stats adds up the threads", "[stats]")
+{
+    struct Tag {};
+    using Stats = LP::counting_stats<Tag>;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            counted_map<Tag> map;
+            map.reserve(1000);
+            for (int i = 0; i < 1000; i++) {
+                map[i] = i;
+            }
+            for (int i = 0; i < 1000; i++) {
+                map.count(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(Stats::snapshot().lookups == 4 * 2000);
+
+    const std::string text = LP::to_prometheus(Stats::snapshot(), "orders_map");
+    REQUIRE(text.find("# TYPE orders_map_lookups_total counter\n") != std::string::npos);
+    REQUIRE(text.find("\norders_map_lookups_total 8000\n") != std::string::npos);
+    REQUIRE(text.find("orders_map_rehash_seconds_total") != std::string::npos);
+}
+
+TEST_CASE("no_stats is the default", "[stats]")
+{
+    REQUIRE(std::is_same<LP3<int, int>, LP3<int, int, std::hash<int>, std::equal_to<int>,
+                                            std::allocator<std::pair<const int, int>>, LP::linear_probe,
+                                            LP::no_stats>>::value);
+    REQUIRE_FALSE(LP::no_stats::enabled);
+}
@@ -0,0 +1,105 @@
+//
+// Tests for LP3's string hash and equality
+//
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "./../hashmap_implementations/LPmap3.h"
+
+namespace {
+    std::string random_string(std::mt19937& generator, size_t length)
+    {
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::string key(length, '\0');
+        for (auto& c : key) {
+            c = static_cast<char>(byte(generator));
+        }
+        return key;
+    }
+
+    // every key gets the same hash, so every lookup compares keys
+    struct Same_hash {
+        size_t operator()(const std::string&) const { return 42; }
+    };
+}  // namespace
+
+TEST_CASE("same_bytes agrees with memcmp", "[string]")
+{
+    std::mt19937 generator(1);
+    bool same = true;
+    for (size_t length = 0; length <= 300; length++) {
+        const std::string a = random_string(generator, length);
+        same = same && LP::same_bytes(a.data(), std::string(a).data(), length);
+        for (size_t at = 0; at < length; at++) {
+            std::string b = a;
+            b[at] ^= 1;
+            same = same && !LP::same_bytes(a.data(), b.data(), length);
+        }
+    }
+    REQUIRE(same);
+    REQUIRE(LP::string_equal{}("abc", std::string("abc")));
+    REQUIRE_FALSE(LP::string_equal{}("abc", "abcd"));
+}
+
+TEST_CASE("wyhash uses every byte", "[string]")
+{
+    std::mt19937 generator(2);
+    std::unordered_set<size_t> hashes;
+    size_t keys = 0;
+    for (size_t length = 0; length <= 300; length++) {
+        const std::string key = random_string(generator, length);
+        hashes.insert(LP::string_hash{}(key));
+        keys++;
+        for (size_t at = 0; at < length; at++) {
+            std::string flipped = key;
+            flipped[at] ^= 0x80;
+            hashes.insert(LP::string_hash{}(flipped));
+            keys++;
+        }
+    }
+    REQUIRE(hashes.size() == keys);
+    // a string and a string_view of it hash the same
+    const std::string key = "some key that's longer than 16 bytes";
+    REQUIRE(LP::string_hash{}(key) == LP::string_hash{}(std::string_view(key)));
+}
+
+TEST_CASE("LP3 hashes strings with string_hash", "[string]")
+{
+    REQUIRE(std::is_same<LP3<std::string, int>, LP3<std::string, int, LP::string_hash, LP::string_equal>>::value);
+    REQUIRE(std::is_same<LP3<int, int>, LP3<int, int, std::hash<int>, std::equal_to<int>>>::value);
+
+    std::mt19937 generator(3);
+    std::vector<std::string> keys;
+    for (size_t length : {8, 16, 31, 32, 33, 64, 100, 256}) {
+        for (int i = 0; i < 1000; i++) {
+            keys.push_back(random_string(generator, length));
+        }
+    }
+    LP3<std::string, int> map;
+    for (size_t i = 0; i < keys.size(); i++) {
+        map[keys[i]] = static_cast<int>(i);
+    }
+    bool found = true;
+    for (size_t i = 0; i < keys.size(); i++) {
+        found = found && map.at(keys[i]) == static_cast<int>(i);
+        found = found && map.count(keys[i].substr(1)) == 0;
+    }
+    REQUIRE(found);
+
+    // keys that only differ in their last byte, all with the same hash
+    LP3<std::string, int, Same_hash> collisions;
+    std::string base(100, 'x');
+    for (int i = 0; i < 50; i++) {
+        base.back() = static_cast<char>('0' + i);
+        collisions[base] = i;
+    }
+    REQUIRE(collisions.size() == 50);
+    base.back() = '0' + 20;
+    REQUIRE(collisions.at(base) == 20);
+}
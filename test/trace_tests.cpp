@@ -0,0 +1,118 @@
+//
+// Tests for LP3's resize tracing
+//
+#include <catch2/catch.hpp>
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "./../hashmap_implementations/LPmap3.h"
+
+using Phase = LP::Resize_event::Phase;
+
+TEST_CASE("on_resize sees every rehash start and end", "[trace]")
+{
+    LP3<int, int> map;
+    std::vector<LP::Resize_event> events;
+    map.on_resize([&](const LP::Resize_event& event) { events.push_back(event); });
+
+    for (int i = 0; i < 10000; i++) {
+        map[i] = i;
+    }
+    REQUIRE(!events.empty());
+    REQUIRE(events.size() % 2 == 0);
+    for (size_t e = 0; e < events.size(); e += 2) {
+        const auto& start = events[e];
+        const auto& end = events[e + 1];
+        REQUIRE(start.phase == Phase::start);
+        REQUIRE(end.phase == Phase::end);
+        REQUIRE(start.cause == LP::Resize_cause::insert);
+        REQUIRE(end.cause == LP::Resize_cause::insert);
+        REQUIRE(start.old_buckets < start.new_buckets);
+        REQUIRE(start.new_buckets == end.new_buckets);
+        REQUIRE(end.timestamp >= start.timestamp);
+        REQUIRE(end.nanoseconds == end.timestamp - start.timestamp);
+        REQUIRE(start.nanoseconds == 0);
+        REQUIRE_FALSE(start.in_place);
+    }
+    REQUIRE(events.back().new_buckets == map.bucket_count());
+
+    events.clear();
+    for (int i = 0; i < 100; i++) {
+        map.erase(i);
+    }
+    map.in_place_rehash(true);
+    map.purge_tombstones();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].cause == LP::Resize_cause::purge_tombstones);
+    REQUIRE(events[0].tombstones == 100);
+    REQUIRE(events[0].live == 9900);
+    REQUIRE(events[1].tombstones == 0);
+    REQUIRE(events[1].in_place);
+
+    events.clear();
+    map.reserve(100000);
+    map.shrink_to_fit();
+    REQUIRE(events.size() == 4);
+    REQUIRE(events[0].cause == LP::Resize_cause::reserve);
+    REQUIRE(events[2].cause == LP::Resize_cause::shrink_to_fit);
+    REQUIRE(std::string(LP::to_string(events[2].cause)) == "shrink_to_fit");
+
+    events.clear();
+    map.min_load_factor(0.2f);
+    for (int i = 100; i < 9000; i++) {
+        map.erase(i);
+    }
+    REQUIRE(!events.empty());
+    REQUIRE(events[0].cause == LP::Resize_cause::erase);
+    REQUIRE(events[0].new_buckets < events[0].old_buckets);
+
+    // copies keep the hook, an empty one turns it off
+    auto copy = map;
+    events.clear();
+    copy.rehash();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].cause == LP::Resize_cause::rehash);
+    copy.on_resize(nullptr);
+    copy.rehash();
+    REQUIRE(events.size() == 2);
+}
+
+TEST_CASE("resize_ring keeps the last events", "[trace]")
+{
+    LP::resize_ring<64> ring;
+    REQUIRE(ring.events().empty());
+    LP3<int, int> map;
+    map.on_resize(std::ref(ring));
+    map.reserve(1000);
+    REQUIRE(ring.pushed() == 2);
+    REQUIRE(ring.events().size() == 2);
+    REQUIRE(ring.events()[1].phase == Phase::end);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&ring, t] {
+            for (uint64_t i = 0; i < 1000; i++) {
+                LP::Resize_event event{};
+                event.old_buckets = t;
+                event.new_buckets = i;
+                ring.push(event);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(ring.pushed() == 4002);
+    auto events = ring.events();
+    REQUIRE(events.size() == 64);
+    // every thread's events come out in the order it pushed them
+    std::vector<int64_t> last(4, -1);
+    bool ordered = true;
+    for (const auto& event : events) {
+        ordered = ordered && static_cast<int64_t>(event.new_buckets) > last[event.old_buckets];
+        last[event.old_buckets] = event.new_buckets;
+    }
+    REQUIRE(ordered);
+}